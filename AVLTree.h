@@ -25,6 +25,12 @@
  * the single parameter value version of these functions just call the 
  * recursive version with the root parameter
  * 
+ * Nodes can come from an AVLNodePool instead of new/delete, the pool
+ * hands out nodes from chunks it keeps between uses and reset() drops
+ * every node at once, so a tree that is built and thrown away over and
+ * over (like the AI's move tree) stops hitting malloc. A tree with a pool
+ * of trivially destructible values skips the walk in its destructor.
+ * 
  */
 
 #ifndef AVLTREE_H
@@ -39,6 +45,10 @@
 #include <sstream>
 #include <functional>
 #include <map>
+#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <new>
 using namespace std;
 
 // struct for tree nodes
@@ -51,6 +61,35 @@ struct AVLNode {
     AVLNode(T value) : data(value), left(nullptr), right(nullptr), height(0) {}
 };
 
+// arena for tree nodes
+// nodes are carved out of fixed size chunks, removed nodes go on a free list,
+// reset() makes every chunk available again without freeing them
+// not thread safe, use one pool per thread
+template <typename T>
+class AVLNodePool {
+private:
+    // raw storage for one node
+    struct alignas(AVLNode<T>) NodeSlot {
+        unsigned char bytes[sizeof(AVLNode<T>)];
+    };
+
+    std::vector<std::unique_ptr<NodeSlot[]>> chunks;
+    size_t chunkIndex;      // chunk nodes are being carved from
+    size_t used;            // slots used in that chunk
+    NodeSlot* freeList;     // released slots, each holds the next one's address
+
+public:
+    static const size_t CHUNK_NODES = 256;
+
+    AVLNodePool();
+    AVLNodePool(const AVLNodePool&) = delete;
+    AVLNodePool& operator=(const AVLNodePool&) = delete;
+    AVLNode<T>* allocate(T value);          // construct a node
+    void release(AVLNode<T>* node);         // destroy a node and keep its slot
+    void reset();                           // drop every node, O(1)
+    size_t capacity() const;                // nodes the chunks can hold
+};
+
 template <typename T>
 class AVLTree {
 private:
@@ -68,11 +107,17 @@ private:
 
     // store result
     static constexpr bool has_less = decltype(has_less_operator<T>(0))::value;
+
+    // where nodes come from, nullptr for new/delete
+    AVLNodePool<T>* pool;
+    AVLNode<T>* create_node(T value);
+    void destroy_node(AVLNode<T>* node);
     
     void display_tree_helper(AVLNode<T>* node, const std::string& prefix, bool is_left) const;
 
 public:
    AVLTree();
+   explicit AVLTree(AVLNodePool<T>* nodePool);         // nodes come from the pool
    ~AVLTree();
    AVLNode<T>* insert(T value);                         // insert node with value
    AVLNode<T>* insert(AVLNode<T>* parent, T value);     // recursive insert
@@ -95,31 +140,111 @@ public:
 };
 
 
+// pool constructor
+template <typename T>
+AVLNodePool<T>::AVLNodePool() : chunkIndex(0), used(0), freeList(nullptr) {}
+
+// construct a node, reusing a released slot first
+template <typename T>
+AVLNode<T>* AVLNodePool<T>::allocate(T value) {
+    void* slot;
+    if (freeList != nullptr) {
+        slot = freeList;
+        std::memcpy(&freeList, freeList->bytes, sizeof(NodeSlot*));
+    } else {
+        // move to the next chunk when this one is full, keep chunks from before a reset
+        if (chunks.empty() || used == CHUNK_NODES) {
+            if (!chunks.empty()) {
+                ++chunkIndex;
+            }
+            if (chunkIndex == chunks.size()) {
+                chunks.emplace_back(new NodeSlot[CHUNK_NODES]);
+            }
+            used = 0;
+        }
+        slot = &chunks[chunkIndex][used++];
+    }
+    return new (slot) AVLNode<T>(value);
+}
+
+// destroy a node and put its slot on the free list
+template <typename T>
+void AVLNodePool<T>::release(AVLNode<T>* node) {
+    node->~AVLNode<T>();
+    NodeSlot* slot = reinterpret_cast<NodeSlot*>(node);
+    std::memcpy(slot->bytes, &freeList, sizeof(NodeSlot*));
+    freeList = slot;
+}
+
+// drop every node, the chunks are kept for the next use
+// nodes still in a tree must not be used after this
+template <typename T>
+void AVLNodePool<T>::reset() {
+    chunkIndex = 0;
+    used = 0;
+    freeList = nullptr;
+}
+
+// nodes the chunks can hold
+template <typename T>
+size_t AVLNodePool<T>::capacity() const {
+    return chunks.size() * CHUNK_NODES;
+}
+
+
 // constructor
 template <typename T>
-AVLTree<T>::AVLTree() : root(nullptr) {}
+AVLTree<T>::AVLTree() : root(nullptr), pool(nullptr) {}
+
+// constructor, nodes come from the pool which must outlive the tree
+template <typename T>
+AVLTree<T>::AVLTree(AVLNodePool<T>* nodePool) : root(nullptr), pool(nodePool) {}
 
 // destructor
 template <typename T>
 AVLTree<T>::~AVLTree() {
+    // the pool gets its slots back on reset, nothing to run per node
+    if (pool != nullptr && std::is_trivially_destructible<T>::value) {
+        return;
+    }
+
     // delete tree
     std::function<void(AVLNode<T>*)> delete_subtree = [&](AVLNode<T>* node) {
         if (node) {
             delete_subtree(node->left);
             delete_subtree(node->right);
-            delete node;
+            destroy_node(node);
         }
     };
 
     delete_subtree(root);
 }
 
+// make a node from the pool or the heap
+template <typename T>
+AVLNode<T>* AVLTree<T>::create_node(T value) {
+    if (pool != nullptr) {
+        return pool->allocate(value);
+    }
+    return new AVLNode<T>(value);
+}
+
+// free a node made by create_node
+template <typename T>
+void AVLTree<T>::destroy_node(AVLNode<T>* node) {
+    if (pool != nullptr) {
+        pool->release(node);
+    } else {
+        delete node;
+    }
+}
+
 // insert node into tree
 template <typename T>
 AVLNode<T>* AVLTree<T>::insert(AVLNode<T>* parent, T value) {
     // if tree is empty, new node is root
     if (parent==nullptr) {
-        root = new AVLNode<T>(value);
+        root = create_node(value);
         return root;
     }
     
@@ -188,16 +313,16 @@ bool AVLTree<T>::remove(AVLNode<T>*& node, T value) {
         return removed;
     } else { // value is in this node <> checked
         if (node->left == nullptr && node->right == nullptr) {  // leaf node
-            delete node;
+            destroy_node(node);
             node = nullptr;
         } else if (node->left == nullptr) {  // only right child
             AVLNode<T>* temp = node;
             node = node->right;
-            delete temp;
+            destroy_node(temp);
         } else if (node->right == nullptr) {  // only left child
             AVLNode<T>* temp = node;
             node = node->left;
-            delete temp;
+            destroy_node(temp);
         } else { // left and right children
             // find smallest (left) node in right tree
             AVLNode<T>* successor = node->right;
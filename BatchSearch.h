@@ -0,0 +1,147 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Batched AI Moves
+ *
+ * getAIMoves searches the AI turns of many games together. Every search
+ * of the batch is a task on a WorkStealingPool and they all use one
+ * transposition table, so positions the games have in common (the same
+ * opening, a transposition a few plies in) are searched by one of them
+ * and read from the table by the rest. The table is aged once per batch
+ * instead of once per move, so one game's entries aren't replaceable
+ * just because another game's search started.
+ *
+ * The cores are shared between the games, each search runs single
+ * threaded whatever options.threads says. A result is handed to the
+ * callback on the worker that produced it as soon as it is done, in
+ * whatever order the searches finish.
+ *
+ */
+
+#ifndef BATCHSEARCH_H
+#define BATCHSEARCH_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// include board implementation
+#include "Board.h"
+// include search implementation
+#include "Search.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include work stealing pool implementation
+#include "WorkStealingPool.h"
+
+
+// one AI turn of a batch
+struct AIMoveRequest {
+    // picked by the caller, handed back with the result
+    uint64_t id;
+    Board board;
+    int player;
+};
+
+// a finished AI turn
+struct AIMoveResult {
+    uint64_t id;
+    std::pair<int, int> move;
+    // the search threw, message says why
+    bool failed;
+    std::string message;
+};
+
+
+// starts searching every request of a batch and returns without waiting
+//
+// parameters:
+// const AIMoveRequest* requests - the turns, copied so they can go away once this returns
+// size_t count - the number of requests
+// WorkStealingPool& pool - runs the searches
+// TranspositionTable& table - shared by the searches, it has to outlive them
+// const SearchOptions& options - the search for every turn
+// std::function<void(const AIMoveResult&)> onResult - called on a worker as each search finishes
+//
+// returns:
+// void - does not return a value
+
+inline void getAIMoves(
+    const AIMoveRequest* requests,
+    size_t count,
+    WorkStealingPool& pool,
+    TranspositionTable& table,
+    const SearchOptions& options,
+    std::function<void(const AIMoveResult&)> onResult
+) {
+    if (count == 0) {
+        return;
+    }
+    SearchOptions batchOptions = options;
+    batchOptions.threads = 1;
+    batchOptions.ageTable = false;
+    table.newSearch();
+
+    auto shared = std::make_shared<std::function<void(const AIMoveResult&)>>(std::move(onResult));
+    std::vector<WorkStealingPool::Task> tasks;
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        tasks.emplace_back([request = requests[i], &table, batchOptions, shared]() mutable {
+            AIMoveResult result{request.id, {-1, -1}, false, ""};
+            try {
+                MoveList validMoves = request.board.getValidMoves(request.player);
+                result.move = getAIMove(validMoves, request.board, request.player, table, batchOptions);
+            } catch (const std::exception& e) {
+                result.failed = true;
+                result.message = e.what();
+            }
+            (*shared)(result);
+        });
+    }
+    pool.submit(tasks);
+}
+
+// searches every request of a batch and waits for them all
+//
+// parameters:
+// const std::vector<AIMoveRequest>& requests - the turns
+// WorkStealingPool& pool - runs the searches
+// TranspositionTable& table - shared by the searches
+// const SearchOptions& options - the search for every turn
+//
+// returns:
+// std::vector<AIMoveResult> - one result per request, in the order they finished
+
+inline std::vector<AIMoveResult> getAIMoves(
+    const std::vector<AIMoveRequest>& requests,
+    WorkStealingPool& pool,
+    TranspositionTable& table,
+    const SearchOptions& options
+) {
+    std::vector<AIMoveResult> results;
+    results.reserve(requests.size());
+    std::mutex mutex;
+    std::condition_variable done;
+
+    getAIMoves(requests.data(), requests.size(), pool, table, options, [&](const AIMoveResult& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(result);
+        if (results.size() == requests.size()) {
+            done.notify_one();
+        }
+    });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return results.size() == requests.size(); });
+    return results;
+}
+
+#endif /* BATCHSEARCH_H */
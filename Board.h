@@ -0,0 +1,1430 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Board Implementation
+ *
+ * The board can be stored in one of three backends
+ *
+ * MAP      - std::map of BoardSquares keyed by (row, col), works for any size
+ * FLAT     - one contiguous std::vector<uint8_t> with a ring of sentinel
+ *            squares around the board, works for any size
+ * BITBOARD - two uint64_t masks (one per player), used when the board has
+ *            at most 64 squares (8x8 or smaller)
+ *
+ * The bitboard uses a fixed stride of 8 bits per row so the same shift
+ * amounts work for every board size <= 8, squares outside the board are
+ * masked out after every shift so pieces never wrap around an edge.
+ *
+ * The flat board is (size + 2) x (size + 2), the outer ring holds
+ * BORDER_SQUARE so a walk in any direction stops at the edge without
+ * checking bounds. Copying a flat board is a single allocation and memcpy.
+ *
+ * All backends expose the same getValidMoves/placePiece/showWinner
+ * semantics so the game loop and the AI search don't need to know which
+ * one is in use.
+ *
+ * Valid moves are returned in a MoveList, an array of 64 moves on the
+ * stack, each Move stores how many pieces flip in every direction (and a
+ * flip mask on boards 8x8 or smaller) so generating moves never touches
+ * the heap on boards up to 8x8. That part is a deliberate trade: a larger
+ * board can have any number of moves, so a list past 64 moves goes to a
+ * heap block that grows as needed instead of a fixed array big enough for
+ * every position living on the stack at every ply.
+ *
+ * The map and flat boards keep a frontier, the empty squares next to at
+ * least one piece, as one bit per padded square. Only a frontier square
+ * can be a legal move, so getValidMoves walks the set bits (in row-major
+ * order, like the full scan it replaces) instead of every empty square.
+ * Flips don't change which squares are occupied, so placePiece and
+ * undoMove only update the 8 neighbours of the square played.
+ *
+ * Every board keeps a 64 bit zobrist key (XOR of a random key per piece
+ * per square), placePiece XORs in the placed piece and the flipped
+ * squares so the key never has to be rebuilt.
+ *
+ * undoMove takes a move back using the flips stored in the Move, so the
+ * search makes and unmakes moves on one board instead of copying it at
+ * every node.
+ *
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <iostream>
+#include <map>
+#include <utility>
+#include <stack>
+#include <list>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+
+// list of directions used to check for flippable pieces around a position on the board
+// each pair represents a direction (e.g., {-1, 0} is north, {1, 1} is southeast)
+// used to check for anchor points
+const std::list<std::pair<int, int>> directions = {
+    {-1, 0},  // north
+    {1, 0},   // south
+    {0, -1},  // west
+    {0, 1},   // east
+    {-1, -1}, // northwest
+    {-1, 1},  // northeast
+    {1, -1},  // southwest
+    {1, 1}    // southeast
+};
+
+// number of directions
+const int DIRECTION_COUNT = 8;
+
+// row and column steps of each direction, same order as directions
+constexpr int DIRECTION_ROWS[DIRECTION_COUNT] = {-1, 1, 0, 0, -1, -1, 1, 1};
+constexpr int DIRECTION_COLS[DIRECTION_COUNT] = {0, 0, -1, 1, -1, 1, -1, 1};
+
+// bitboard shift for each direction, same order as directions
+// a row is always 8 bits wide so north/south is a shift by 8
+constexpr int BITBOARD_SHIFTS[DIRECTION_COUNT] = {
+    -8, // north
+     8, // south
+    -1, // west
+     1, // east
+    -9, // northwest
+    -7, // northeast
+     7, // southwest
+     9  // southeast
+};
+
+// the bitboard stride (bits per row)
+const int BITBOARD_STRIDE = 8;
+
+// value of the sentinel squares around a flat board
+const uint8_t BORDER_SQUARE = 3;
+
+// number of squares the precomputed zobrist table covers (64x64 boards),
+// keys for squares past this are generated on the fly with the same function
+const int ZOBRIST_TABLE_SQUARES = 64 * 64;
+
+// one step of splitmix64, used to generate the zobrist keys
+//
+// parameters:
+// uint64_t x - the value to mix
+//
+// returns:
+// uint64_t - a well mixed 64 bit value
+inline uint64_t splitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// retrieves the zobrist key for a player's piece on a square
+// the key of a board is the XOR of the keys of every piece on it
+//
+// parameters:
+// int square - the square index (row * boardSize + col)
+// int player - the player number (1 for 'X', 2 for 'O')
+//
+// returns:
+// uint64_t - the key for that piece
+inline uint64_t zobristKey(int square, int player) {
+    // filled once on first use
+    static const std::vector<uint64_t> table = [] {
+        std::vector<uint64_t> keys(ZOBRIST_TABLE_SQUARES * 2);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keys[i] = splitMix64(i);
+        }
+        return keys;
+    }();
+
+    uint64_t index = uint64_t(square) * 2 + (player - 1);
+    return (square < ZOBRIST_TABLE_SQUARES) ? table[index] : splitMix64(index);
+}
+
+// retrieves the key mixed into a position key for the side to move
+// so the same board with a different player to move is a different position
+//
+// parameters:
+// int player - the player to move (1 for 'X', 2 for 'O')
+//
+// returns:
+// uint64_t - the key for the side to move, 0 for player X
+inline uint64_t zobristSideKey(int player) {
+    return (player == 2) ? splitMix64(~uint64_t(0)) : 0;
+}
+
+// retrieves the value to XOR into a zobrist key when the piece on a square flips
+//
+// parameters:
+// int square - the square index (row * boardSize + col)
+//
+// returns:
+// uint64_t - the key that swaps player X's piece for player O's
+inline uint64_t zobristFlipKey(int square) {
+    // filled once on first use, flips are the most frequent key update
+    static const std::vector<uint64_t> table = [] {
+        std::vector<uint64_t> keys(ZOBRIST_TABLE_SQUARES);
+        for (int i = 0; i < ZOBRIST_TABLE_SQUARES; ++i) {
+            keys[i] = zobristKey(i, 1) ^ zobristKey(i, 2);
+        }
+        return keys;
+    }();
+
+    return (square < ZOBRIST_TABLE_SQUARES) ? table[square] : zobristKey(square, 1) ^ zobristKey(square, 2);
+}
+
+// struct to store player moves,
+// used in the game history stack
+struct PlayerMove {
+    int thePlayer;
+    std::pair<int,int> theLocation;
+
+    PlayerMove(int player, std::pair<int,int> location) {
+        thePlayer = player;
+        theLocation = location;
+    }
+};
+
+// class representing a single square on the board
+// which can be empty or occupied by a player
+class BoardSquare {
+private:
+    // 0 for empty
+    // 1 for player X
+    // 2 for player 0
+    int value;
+
+public:
+    // constructor to initialize a square as empty
+    BoardSquare() {
+        value = 0;
+    }
+
+
+    // sets a piece for the specified player, throws an error if the square is already occupied
+    //
+    // parameters:
+    // int player - the player placing a piece (1 for 'X', 2 for 'O')
+    //
+    // throws:
+    // std::runtime_error if the square is already occupied
+    void setPiece(int player) {
+        if (value != 0) {
+            throw std::runtime_error("square is already occupied.");
+        }
+        value = player;
+    }
+
+    // flips the piece on the square (from 'X' to 'O' or vice versa),
+    // throws an error if the square is empty
+    //
+    // throws:
+    // std::runtime_error if the square is empty
+    void flipPiece() {
+        if (value == 0) {
+            throw std::runtime_error("cannot flip an empty square.");
+        }
+        value = (value == 1) ? 2 : 1; // flip between 1 and 2
+    }
+
+    // empties the square, used to take back a move
+    //
+    // throws:
+    // std::runtime_error if the square is already empty
+    void clearPiece() {
+        if (value == 0) {
+            throw std::runtime_error("square is already empty.");
+        }
+        value = 0;
+    }
+
+    // retrieves the value of the square
+    //
+    // returns:
+    // int - the value of the square (0 for empty, 1 for 'X', 2 for 'O')
+    int getValue() const {
+        return value;
+    }
+
+    // checks if the square is empty
+    //
+    // returns:
+    // bool - true if the square is empty, false otherwise
+    bool isEmpty() const {
+        return value == 0;
+    }
+};
+
+// a single valid move and the pieces it flips
+// the flips are stored inline as a run length for each direction
+// (same order as directions) so no container is needed
+// 16 bit fields keep it at 24 bytes, a board is never 32767 squares wide
+struct Move {
+    int16_t row;
+    int16_t col;
+    // total number of pieces flipped
+    int16_t flipCount;
+    // how many pieces flip walking away from the move in each direction
+    uint8_t directionFlips[DIRECTION_COUNT];
+    // the flipped squares as a bitboard, only set on boards 8x8 or smaller
+    uint64_t flipMask;
+
+    // retrieves the position of the move
+    //
+    // returns:
+    // std::pair<int, int> - the (row, col) of the move
+    std::pair<int, int> position() const {
+        return {row, col};
+    }
+};
+
+// a growable array that keeps its first InlineCapacity items in place, so a
+// short list never allocates, a list that grows past that moves to a heap
+// block that doubles as needed
+// the items are plain structs, copied with std::copy and not initialized
+template <typename T, int InlineCapacity>
+class InlineBuffer {
+private:
+    T inlineItems[InlineCapacity];
+    // only allocated once the inline items are used up
+    std::unique_ptr<T[]> heapItems;
+    // inlineItems or heapItems
+    T* items;
+    int count;
+    int capacity;
+
+    // moves the items into a larger heap block
+    //
+    // parameters:
+    // int minimum - the number of items the block must hold
+    //
+    // returns:
+    // void - does not return a value
+    void grow(int minimum) {
+        int larger = std::max(capacity * 2, minimum);
+        std::unique_ptr<T[]> block(new T[larger]);
+        std::copy(items, items + count, block.get());
+        heapItems = std::move(block);
+        items = heapItems.get();
+        capacity = larger;
+    }
+
+public:
+    InlineBuffer() : items(inlineItems), count(0), capacity(InlineCapacity) {}
+
+    // copies only the items in use, not the whole capacity
+    InlineBuffer(const InlineBuffer& other) : items(inlineItems), count(0), capacity(InlineCapacity) {
+        *this = other;
+    }
+
+    // takes over a heap block instead of copying it
+    InlineBuffer(InlineBuffer&& other) noexcept : items(inlineItems), count(other.count), capacity(InlineCapacity) {
+        if (other.items == other.inlineItems) {
+            std::copy(other.items, other.items + other.count, inlineItems);
+        } else {
+            heapItems = std::move(other.heapItems);
+            items = heapItems.get();
+            capacity = other.capacity;
+            other.items = other.inlineItems;
+            other.capacity = InlineCapacity;
+        }
+        other.count = 0;
+    }
+
+    InlineBuffer& operator=(const InlineBuffer& other) {
+        if (this != &other) {
+            count = 0;
+            if (other.count > capacity) {
+                grow(other.count);
+            }
+            count = other.count;
+            std::copy(other.items, other.items + other.count, items);
+        }
+        return *this;
+    }
+
+    // appends an item, growing the list if it is full
+    //
+    // returns:
+    // T& - the new item, not initialized
+    T& append() {
+        if (count == capacity) {
+            grow(count + 1);
+        }
+        return items[count++];
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+};
+
+// list of moves that lives on the stack
+// used instead of a map of sets so generating moves doesn't allocate, up to
+// INLINE_CAPACITY moves (every position on boards 8x8 or smaller) are kept
+// in place, a list that grows past that moves to the heap
+class MoveList {
+public:
+    // moves kept in the list itself, about 1.5 KB per ply
+    static const int INLINE_CAPACITY = 64;
+
+private:
+    InlineBuffer<Move, INLINE_CAPACITY> moves;
+
+public:
+    // appends a move
+    //
+    // parameters:
+    // const Move& move - the move to add
+    //
+    // returns:
+    // void - does not return a value
+    void add(const Move& move) {
+        moves.append() = move;
+    }
+
+    // appends a move at a position and returns it so the caller can fill in the flips
+    //
+    // parameters:
+    // int row - the row of the move
+    // int col - the column of the move
+    //
+    // returns:
+    // Move& - the new move
+    Move& add(int row, int col) {
+        Move& move = moves.append();
+        move.row = static_cast<int16_t>(row);
+        move.col = static_cast<int16_t>(col);
+        return move;
+    }
+
+    // finds the move at a position
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the position to look for
+    //
+    // returns:
+    // const Move* - the move, or nullptr if there is no move at the position
+    const Move* find(const std::pair<int, int>& position) const {
+        for (const Move& move : moves) {
+            if (move.row == position.first && move.col == position.second) {
+                return &move;
+            }
+        }
+        return nullptr;
+    }
+
+    int size() const { return moves.size(); }
+    bool empty() const { return moves.empty(); }
+    void clear() { moves.clear(); }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move* begin() { return moves.begin(); }
+    Move* end() { return moves.end(); }
+    const Move* begin() const { return moves.begin(); }
+    const Move* end() const { return moves.end(); }
+};
+
+// how the board stores its squares
+enum class BoardBackend {
+    MAP,        // std::map of BoardSquare, any size
+    FLAT,       // padded contiguous std::vector<uint8_t>, any size
+    BITBOARD    // two uint64_t masks, at most 64 squares
+};
+
+class Board {
+private:
+    // map holds the BoardSquares (MAP backend only)
+    std::map<std::pair<int, int>, BoardSquare> board;
+    int maxBoardSize;
+    BoardBackend backend;
+
+    // one mask per player (BITBOARD backend only)
+    // bitboards[0] for player X, bitboards[1] for player O
+    uint64_t bitboards[2];
+    // mask of the bits that are on the board
+    uint64_t squareMask;
+    // per direction, the squares whose neighbour that way is on the board
+    uint64_t shiftMasks[DIRECTION_COUNT];
+
+    // padded squares (FLAT backend only)
+    // 0 for empty, 1 for player X, 2 for player O, BORDER_SQUARE off the board
+    std::vector<uint8_t> cells;
+    // cells per padded row
+    int flatStride;
+    // index offset for each direction, same order as directions
+    int flatOffsets[DIRECTION_COUNT];
+
+    // pieces next to each padded square (MAP and FLAT backends)
+    std::vector<uint8_t> occupiedNeighbours;
+    // one bit per padded square, set for the empty squares next to a piece (MAP and FLAT backends)
+    std::vector<uint64_t> frontier;
+
+    // zobrist key of the pieces on the board, updated by every placePiece
+    uint64_t zobristHash;
+    // square index (row * size + col) offset for each direction, used for the zobrist updates
+    int squareOffsets[DIRECTION_COUNT];
+
+    // converts a board position to its index in the padded cells
+    // throws std::out_of_range if the position is not on the board
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the position on the board
+    //
+    // returns:
+    // int - the index into cells
+    int positionToIndex(const std::pair<int, int>& position) const {
+        if (position.first < 0 || position.first >= maxBoardSize ||
+            position.second < 0 || position.second >= maxBoardSize) {
+            throw std::out_of_range("position is not on the board.");
+        }
+        return (position.first + 1) * flatStride + (position.second + 1);
+    }
+
+    // converts a padded index back to a board position
+    //
+    // parameters:
+    // int index - the index into cells
+    //
+    // returns:
+    // std::pair<int, int> - the (row, col) for the index
+    std::pair<int, int> indexToPosition(int index) const {
+        return {index / flatStride - 1, index % flatStride - 1};
+    }
+
+    // counts the opponent pieces that would flip walking from an index in one direction
+    // the sentinel ring stops the walk so no bounds checks are needed
+    //
+    // parameters:
+    // int index - the index of the square being played
+    // int player - the player number (1 for 'X', 2 for 'O')
+    // int offset - the index offset of the direction
+    //
+    // returns:
+    // int - the number of pieces to flip, 0 if the line isn't anchored
+    int flatFlipCount(int index, int player, int offset) const {
+        int opponent = (player == 1) ? 2 : 1;
+        int count = 0;
+        index += offset;
+        while (cells[index] == opponent) {
+            ++count;
+            index += offset;
+        }
+        return (cells[index] == player) ? count : 0;
+    }
+
+    // checks if a padded index is an empty square on the board (MAP and FLAT backends)
+    //
+    // parameters:
+    // int index - the padded index
+    //
+    // returns:
+    // bool - false for occupied squares and the border ring
+    bool isEmptyIndex(int index) const {
+        if (backend == BoardBackend::FLAT) {
+            return cells[index] == 0;
+        }
+        std::pair<int, int> position = indexToPosition(index);
+        if (position.first < 0 || position.first >= maxBoardSize ||
+            position.second < 0 || position.second >= maxBoardSize) {
+            return false;
+        }
+        return board.at(position).isEmpty();
+    }
+
+    // updates the frontier after a piece was put on a square
+    //
+    // parameters:
+    // int index - the padded index of the square
+    //
+    // returns:
+    // void - does not return a value
+    void occupyFrontier(int index) {
+        frontier[index >> 6] &= ~(uint64_t(1) << (index & 63));
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int neighbour = index + flatOffsets[d];
+            if (++occupiedNeighbours[neighbour] == 1 && isEmptyIndex(neighbour)) {
+                frontier[neighbour >> 6] |= uint64_t(1) << (neighbour & 63);
+            }
+        }
+    }
+
+    // updates the frontier after a square was emptied
+    //
+    // parameters:
+    // int index - the padded index of the square
+    //
+    // returns:
+    // void - does not return a value
+    void vacateFrontier(int index) {
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int neighbour = index + flatOffsets[d];
+            if (--occupiedNeighbours[neighbour] == 0) {
+                frontier[neighbour >> 6] &= ~(uint64_t(1) << (neighbour & 63));
+            }
+        }
+        if (occupiedNeighbours[index] > 0) {
+            frontier[index >> 6] |= uint64_t(1) << (index & 63);
+        }
+    }
+
+    // converts a board position to its bit in the bitboard
+    // throws std::out_of_range if the position is not on the board
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the position on the board
+    //
+    // returns:
+    // uint64_t - a mask with only the bit for the position set
+    uint64_t positionToBit(const std::pair<int, int>& position) const {
+        if (position.first < 0 || position.first >= maxBoardSize ||
+            position.second < 0 || position.second >= maxBoardSize) {
+            throw std::out_of_range("position is not on the board.");
+        }
+        return uint64_t(1) << (position.first * BITBOARD_STRIDE + position.second);
+    }
+
+    // converts a bit index back to a board position
+    //
+    // parameters:
+    // int bitIndex - the index of the bit (0-63)
+    //
+    // returns:
+    // std::pair<int, int> - the (row, col) for the bit
+    static std::pair<int, int> bitToPosition(int bitIndex) {
+        return {bitIndex / BITBOARD_STRIDE, bitIndex % BITBOARD_STRIDE};
+    }
+
+    // shifts every bit in the mask one square in the given direction
+    // bits that would leave the board (or wrap to the next row) are dropped
+    //
+    // parameters:
+    // uint64_t bits - the mask to shift
+    // int directionIndex - index into BITBOARD_SHIFTS
+    //
+    // returns:
+    // uint64_t - the shifted mask
+    uint64_t shiftBits(uint64_t bits, int directionIndex) const {
+        // drop the squares that would leave the board (or wrap to the next row) first
+        bits &= shiftMasks[directionIndex];
+        int shift = BITBOARD_SHIFTS[directionIndex];
+        return (shift > 0) ? (bits << shift) : (bits >> -shift);
+    }
+
+    // computes the squares that would be flipped by the player placing at a bit
+    // and records them in the move
+    //
+    // parameters:
+    // uint64_t moveBit - the bit of the square being played
+    // int player - the player number (1 for 'X', 2 for 'O')
+    // Move& move - filled with the flip mask and flip count per direction
+    //
+    // returns:
+    // void - does not return a value
+    void bitboardFlips(uint64_t moveBit, int player, Move& move) const {
+        uint64_t own = bitboards[player - 1];
+        uint64_t opponent = bitboards[2 - player];
+        uint64_t flips = 0;
+        move.flipCount = 0;
+        bitboardFlipLine<0>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<1>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<2>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<3>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<4>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<5>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<6>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<7>(moveBit, own, opponent, move, flips);
+        move.flipMask = flips;
+    }
+
+    // walks one direction for bitboardFlips, the direction is a template
+    // parameter so the shift is a constant, the pieces are counted as they're
+    // walked (without -mpopcnt a popcount is a library call)
+    template <int D>
+    void bitboardFlipLine(uint64_t moveBit, uint64_t own, uint64_t opponent, Move& move, uint64_t& flips) const {
+        constexpr int shift = BITBOARD_SHIFTS[D];
+        uint64_t mask = shiftMasks[D];
+        uint64_t line = 0;
+        int count = 0;
+        uint64_t next = moveBit & mask;
+        next = (shift > 0) ? (next << shift) : (next >> -shift);
+        // walk over the opponents pieces
+        while (next & opponent) {
+            line |= next;
+            ++count;
+            next &= mask;
+            next = (shift > 0) ? (next << shift) : (next >> -shift);
+        }
+        // only flip if the line is anchored by our own piece
+        if (!(next & own)) {
+            line = 0;
+            count = 0;
+        }
+        move.directionFlips[D] = static_cast<uint8_t>(count);
+        move.flipCount += count;
+        flips |= line;
+    }
+
+    // builds the bitboard flip mask for a move found by walking the board
+    //
+    // parameters:
+    // const Move& move - the move with its flip count per direction
+    //
+    // returns:
+    // uint64_t - mask of the flipped squares, 0 if the board is larger than 8x8
+    uint64_t flipsToBits(const Move& move) const {
+        if (maxBoardSize > BITBOARD_STRIDE) {
+            return 0;
+        }
+        uint64_t moveBit = uint64_t(1) << (move.row * BITBOARD_STRIDE + move.col);
+        uint64_t flips = 0;
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int shift = BITBOARD_SHIFTS[d];
+            uint64_t bit = moveBit;
+            for (int i = 0; i < move.directionFlips[d]; ++i) {
+                bit = (shift > 0) ? (bit << shift) : (bit >> -shift);
+                flips |= bit;
+            }
+        }
+        return flips;
+    }
+
+    // computes every empty square where the player has a legal move
+    // using shift based propagation in all 8 directions
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // uint64_t - mask of legal move squares
+    uint64_t bitboardLegalMoves(int player) const {
+        uint64_t own = bitboards[player - 1];
+        uint64_t opponent = bitboards[2 - player];
+        uint64_t empty = squareMask & ~(own | opponent);
+        uint64_t legal = 0;
+
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            // opponent pieces adjacent to our pieces in this direction
+            uint64_t line = shiftBits(own, d) & opponent;
+            // extend the line, a line can be at most 6 pieces long on 8x8
+            for (int i = 0; i < BITBOARD_STRIDE - 3; ++i) {
+                line |= shiftBits(line, d) & opponent;
+            }
+            // the empty square just past the line is a legal move
+            legal |= shiftBits(line, d) & empty;
+        }
+        return legal;
+    }
+
+    // flips every piece recorded in the move and updates the zobrist key
+    // the placed piece itself isn't touched, so the same call makes and unmakes the flips
+    //
+    // parameters:
+    // const Move& move - the move whose flips to apply
+    //
+    // returns:
+    // void - does not return a value
+    //
+    // throws:
+    // std::runtime_error if a square to flip is empty
+    void toggleFlips(const Move& move) {
+        std::pair<int, int> position = move.position();
+
+        if (backend == BoardBackend::BITBOARD) {
+            // every flipped square must hold a piece
+            if ((move.flipMask & (bitboards[0] | bitboards[1])) != move.flipMask) {
+                throw std::runtime_error("cannot flip an empty square.");
+            }
+            // the squares belong to exactly one player, so toggling both moves them
+            bitboards[0] ^= move.flipMask;
+            bitboards[1] ^= move.flipMask;
+        } else if (backend == BoardBackend::FLAT) {
+            // flip each run of pieces
+            int index = positionToIndex(position);
+            for (int d = 0; d < DIRECTION_COUNT; ++d) {
+                int flipIndex = index;
+                for (int i = 0; i < move.directionFlips[d]; ++i) {
+                    flipIndex += flatOffsets[d];
+                    uint8_t& cell = cells[flipIndex];
+                    if (cell == 0 || cell == BORDER_SQUARE) {
+                        throw std::runtime_error("cannot flip an empty square.");
+                    }
+                    cell = (cell == 1) ? 2 : 1; // flip between 1 and 2
+                }
+            }
+        } else {
+            // flip each run of pieces
+            int d = 0;
+            for (const auto& direction : directions) {
+                std::pair<int, int> flipPosition = position;
+                for (int i = 0; i < move.directionFlips[d]; ++i) {
+                    flipPosition.first += direction.first;
+                    flipPosition.second += direction.second;
+                    board.at(flipPosition).flipPiece();
+                }
+                ++d;
+            }
+        }
+
+        // XOR the flipped pieces into the key, the placed piece is handled by the caller
+        if (backend == BoardBackend::BITBOARD) {
+            uint64_t flips = move.flipMask;
+            while (flips) {
+                int bitIndex = __builtin_ctzll(flips);
+                flips &= flips - 1;
+                zobristHash ^= zobristFlipKey((bitIndex / BITBOARD_STRIDE) * maxBoardSize + bitIndex % BITBOARD_STRIDE);
+            }
+            return;
+        }
+        int square = position.first * maxBoardSize + position.second;
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int flipSquare = square;
+            for (int i = 0; i < move.directionFlips[d]; ++i) {
+                flipSquare += squareOffsets[d];
+                zobristHash ^= zobristFlipKey(flipSquare);
+            }
+        }
+    }
+
+public:
+    // picks the fastest backend that can hold a board of the given size
+    //
+    // parameters:
+    // int size - the size of the board
+    //
+    // returns:
+    // BoardBackend - BITBOARD if the board fits in 64 bits, FLAT otherwise
+    static BoardBackend defaultBackend(int size) {
+        return (size <= BITBOARD_STRIDE) ? BoardBackend::BITBOARD : BoardBackend::FLAT;
+    }
+
+    // initializes the board with a given size
+    // sets up an empty board, ensuring the size is at least 4x4, and places starting pieces at the center
+    //
+    // parameters:
+    // int size - the size of the board (must be at least 4)
+    //
+    // throws:
+    // std::invalid_argument if the board size is less than 4
+    Board(int size) : Board(size, defaultBackend(size)) {}
+
+    // initializes the board with a given size and storage backend
+    //
+    // parameters:
+    // int size - the size of the board (must be at least 4)
+    // BoardBackend storage - how the squares are stored
+    //
+    // throws:
+    // std::invalid_argument if the board size is less than 4
+    //                       or the board doesn't fit the backend
+    Board(int size, BoardBackend storage)
+        : maxBoardSize(size), backend(storage), bitboards{0, 0}, squareMask(0), shiftMasks{},
+          flatStride(size + 2), flatOffsets{}, zobristHash(0), squareOffsets{} {
+        // check for invalid board
+        if (size < 4) {
+            throw std::invalid_argument("Board size must be at least 4.");
+        }
+        if (backend == BoardBackend::BITBOARD && size > BITBOARD_STRIDE) {
+            throw std::invalid_argument("Bitboard backend supports at most 8x8 boards.");
+        }
+
+        // init an empty board
+        if (backend == BoardBackend::BITBOARD) {
+            // one row of the board, and the edge rows and columns
+            uint64_t rowBits = (uint64_t(1) << maxBoardSize) - 1;
+            for (int row = 0; row < maxBoardSize; ++row) {
+                squareMask |= rowBits << (row * BITBOARD_STRIDE);
+            }
+            uint64_t firstRow = rowBits;
+            uint64_t lastRow = rowBits << ((maxBoardSize - 1) * BITBOARD_STRIDE);
+            uint64_t firstCol = 0;
+            for (int row = 0; row < maxBoardSize; ++row) {
+                firstCol |= uint64_t(1) << (row * BITBOARD_STRIDE);
+            }
+            uint64_t lastCol = firstCol << (maxBoardSize - 1);
+            for (int d = 0; d < DIRECTION_COUNT; ++d) {
+                shiftMasks[d] = squareMask;
+                shiftMasks[d] &= (DIRECTION_ROWS[d] < 0) ? ~firstRow : (DIRECTION_ROWS[d] > 0) ? ~lastRow : ~uint64_t(0);
+                shiftMasks[d] &= (DIRECTION_COLS[d] < 0) ? ~firstCol : (DIRECTION_COLS[d] > 0) ? ~lastCol : ~uint64_t(0);
+            }
+        } else if (backend == BoardBackend::FLAT) {
+            // everything starts as border, then the inside is cleared
+            cells.assign(flatStride * flatStride, BORDER_SQUARE);
+            for (int row = 0; row < maxBoardSize; ++row) {
+                for (int col = 0; col < maxBoardSize; ++col) {
+                    cells[positionToIndex({row, col})] = 0;
+                }
+            }
+        } else {
+            for (int row = 0; row < maxBoardSize; ++row) {
+                for (int col = 0; col < maxBoardSize; ++col) {
+                    board[{row, col}] = BoardSquare();
+                }
+            }
+        }
+
+        int d = 0;
+        for (const auto& direction : directions) {
+            squareOffsets[d] = direction.first * maxBoardSize + direction.second;
+            flatOffsets[d++] = direction.first * flatStride + direction.second;
+        }
+
+        // the frontier covers the padded squares, so the border ring's neighbours exist
+        if (backend != BoardBackend::BITBOARD) {
+            occupiedNeighbours.assign(flatStride * flatStride, 0);
+            frontier.assign((flatStride * flatStride + 63) / 64, 0);
+        }
+
+        // find center to place starting pieces
+        int center = maxBoardSize / 2;
+
+        // set up starting pieces:
+        // 0 1
+        // 1 0
+        try {
+            setStartingPiece({center - 1, center - 1}, 1);  // Top-left of center with Player X (1)
+            setStartingPiece({center - 1, center}, 2);      // Top-right of center with Player O (2)
+            setStartingPiece({center, center - 1}, 2);      // Bottom-left of center with Player O (2)
+            setStartingPiece({center, center}, 1);          // Bottom-right of center with Player X (1)
+        } catch (const std::exception& e) {
+            std::cerr << "Error initializing the board's center pieces: " << e.what() << std::endl;
+        }
+    }
+
+    // places a single piece without flipping anything
+    // used to set up the starting position
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the position to place the piece
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // throws:
+    // std::runtime_error if the square is already occupied
+    void setStartingPiece(const std::pair<int, int>& position, int player) {
+        if (backend == BoardBackend::BITBOARD) {
+            uint64_t bit = positionToBit(position);
+            if ((bitboards[0] | bitboards[1]) & bit) {
+                throw std::runtime_error("square is already occupied.");
+            }
+            bitboards[player - 1] |= bit;
+        } else if (backend == BoardBackend::FLAT) {
+            uint8_t& cell = cells[positionToIndex(position)];
+            if (cell != 0) {
+                throw std::runtime_error("square is already occupied.");
+            }
+            cell = player;
+        } else {
+            board.at(position).setPiece(player);
+        }
+        if (backend != BoardBackend::BITBOARD) {
+            occupyFrontier(positionToIndex(position));
+        }
+        zobristHash ^= zobristKey(position.first * maxBoardSize + position.second, player);
+    }
+
+    // computes the zobrist key of the board from scratch
+    // the search uses getHash, which is kept up to date by placePiece, this is
+    // the reference it has to match
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // uint64_t - XOR of the zobrist keys of every piece on the board
+    uint64_t hashBoard() const {
+        uint64_t boardHash = 0;
+        for (int row = 0; row < maxBoardSize; ++row) {
+            for (int col = 0; col < maxBoardSize; ++col) {
+                int value = getBoardPlaceValue({row, col});
+                if (value != 0) {
+                    boardHash ^= zobristKey(row * maxBoardSize + col, value);
+                }
+            }
+        }
+        return boardHash;
+    }
+
+    // retrieves the incrementally updated zobrist key of the board
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // uint64_t - the key, always equal to hashBoard()
+    uint64_t getHash() const {
+        return zobristHash;
+    }
+
+    // places a piece on the board at the specified location for a given player
+    // flips the pieces recorded in the move
+    //
+    // parameters:
+    // const Move& move - the move to play, as generated by getValidMoves
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // void - does not return a value
+    void placePiece(const Move& move, int player) {
+        // set the square for the player
+        setStartingPiece(move.position(), player);
+        toggleFlips(move);
+    }
+
+    // takes back a move made with placePiece, flipping the same pieces back
+    // and emptying the square, so the search can work on one board in place
+    // moves have to be undone in the reverse order they were made
+    //
+    // parameters:
+    // const Move& move - the move that was played
+    // int player - the player who played it (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // void - does not return a value
+    //
+    // throws:
+    // std::runtime_error if the square doesn't hold the player's piece
+    void undoMove(const Move& move, int player) {
+        std::pair<int, int> position = move.position();
+        if (getBoardPlaceValue(position) != player) {
+            throw std::runtime_error("cannot undo a move that wasn't played.");
+        }
+
+        // flipping is its own inverse
+        toggleFlips(move);
+
+        if (backend == BoardBackend::BITBOARD) {
+            bitboards[player - 1] &= ~positionToBit(position);
+        } else if (backend == BoardBackend::FLAT) {
+            cells[positionToIndex(position)] = 0;
+        } else {
+            board.at(position).clearPiece();
+        }
+        if (backend != BoardBackend::BITBOARD) {
+            vacateFrontier(positionToIndex(position));
+        }
+        zobristHash ^= zobristKey(position.first * maxBoardSize + position.second, player);
+    }
+
+    // retrieves the value at a specified board position
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the position on the board
+    //
+    // returns:
+    // int - the value at the specified position (0 for empty, 1 for 'X', 2 for 'O')
+    int getBoardPlaceValue(const std::pair<int, int>& position) const {
+        if (backend == BoardBackend::BITBOARD) {
+            uint64_t bit = positionToBit(position);
+            if (bitboards[0] & bit) {
+                return 1;
+            }
+            if (bitboards[1] & bit) {
+                return 2;
+            }
+            return 0;
+        }
+        if (backend == BoardBackend::FLAT) {
+            return cells[positionToIndex(position)];
+        }
+        return board.at(position).getValue();
+    }
+
+    // counts the pieces to flip in a given direction for a move by the specified player
+    //
+    // parameters:
+    // std::pair<int, int> position - the starting position for checking flips
+    // int player - the player number (1 for 'X', 2 for 'O')
+    // std::pair<int, int> direction - the direction to check for flippable pieces
+    //
+    // returns:
+    // int - the number of pieces that would flip, 0 if the line has no anchor
+    int findFlippablePieces(
+        std::pair<int, int> position,
+        int player,
+        std::pair<int, int> direction
+    ) const {
+        int piecesToFlip = 0;
+
+        // get value of opponent
+        int opponent = (player == 1) ? 2 : 1;
+
+        // move to the next position in the specified direction
+        position.first += direction.first;
+        position.second += direction.second;
+
+        // traverse the board in that direction
+        // until we reach the end of the board
+        while (position.first >= 0 && position.first < maxBoardSize &&
+               position.second >= 0 && position.second < maxBoardSize) {
+
+            int value = getBoardPlaceValue({position.first, position.second});
+
+            if (value == opponent) {
+                // add opponent's piece to the flip path
+                ++piecesToFlip;
+            } else if (value == player) {
+                // found an anchor piece of the same color
+                return piecesToFlip;
+            } else {
+                // Empty square encountered, no anchor in this direction
+                break;
+            }
+
+            // Move to the next position in the specified direction
+            position.first += direction.first;
+            position.second += direction.second;
+        }
+
+        // No anchor piece found in this direction
+        return 0;
+    }
+
+    // generates all valid moves for a given player based on Othello rules
+    // stores each valid move and its flip counts in a fixed capacity list,
+    // moves are in row-major order
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // MoveList - the valid moves, nothing is allocated on the heap
+    MoveList getValidMoves(int player) const {
+        MoveList validMoves;
+
+        if (backend == BoardBackend::BITBOARD) {
+            // every legal square at once, then the flips for each one
+            uint64_t legal = bitboardLegalMoves(player);
+            while (legal) {
+                int moveIndex = __builtin_ctzll(legal);
+                legal &= legal - 1;
+
+                std::pair<int, int> position = bitToPosition(moveIndex);
+                Move& move = validMoves.add(position.first, position.second);
+                bitboardFlips(uint64_t(1) << moveIndex, player, move);
+            }
+            return validMoves;
+        }
+
+        if (backend == BoardBackend::FLAT) {
+            // walk the frontier in row-major order
+            for (size_t word = 0; word < frontier.size(); ++word) {
+                uint64_t bits = frontier[word];
+                while (bits) {
+                    int index = static_cast<int>(word * 64) + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+
+                    // count the flippable pieces in all directions
+                    Move candidate;
+                    candidate.flipCount = 0;
+                    for (int d = 0; d < DIRECTION_COUNT; ++d) {
+                        int count = flatFlipCount(index, player, flatOffsets[d]);
+                        candidate.directionFlips[d] = count;
+                        candidate.flipCount += count;
+                    }
+
+                    // if there are any flippable pieces, store the move
+                    if (candidate.flipCount > 0) {
+                        std::pair<int, int> position = indexToPosition(index);
+                        candidate.row = position.first;
+                        candidate.col = position.second;
+                        candidate.flipMask = flipsToBits(candidate);
+                        validMoves.add(candidate);
+                    }
+                }
+            }
+            return validMoves;
+        }
+
+        // walk the frontier in row-major order
+        for (size_t word = 0; word < frontier.size(); ++word) {
+            uint64_t bits = frontier[word];
+            while (bits) {
+                int index = static_cast<int>(word * 64) + __builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                // current position we check (row, col)
+                std::pair<int, int> position = indexToPosition(index);
+
+                // count the flippable pieces in all directions
+                Move candidate;
+                candidate.flipCount = 0;
+                int d = 0;
+                for (const auto& direction : directions) {
+                    int count = findFlippablePieces(position, player, direction);
+                    candidate.directionFlips[d++] = count;
+                    candidate.flipCount += count;
+                }
+
+                // if there are any flippable pieces, store the move
+                if (candidate.flipCount > 0) {
+                    candidate.row = position.first;
+                    candidate.col = position.second;
+                    candidate.flipMask = flipsToBits(candidate);
+                    validMoves.add(candidate);
+                }
+            }
+        }
+        return validMoves;  // return the list of valid moves with their flip counts
+    }
+
+    // builds the move for one square without generating the others,
+    // used to replay recorded games
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the square to play
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // Move - the move with its flips, flipCount is 0 if it isn't valid
+    //
+    // throws:
+    // std::out_of_range if the position is not on the board
+    Move getMove(const std::pair<int, int>& position, int player) const {
+        Move move;
+        move.row = position.first;
+        move.col = position.second;
+        move.flipCount = 0;
+        move.flipMask = 0;
+        std::fill(move.directionFlips, move.directionFlips + DIRECTION_COUNT, 0);
+
+        if (backend == BoardBackend::BITBOARD) {
+            uint64_t bit = positionToBit(position);
+            if (!((bitboards[0] | bitboards[1]) & bit)) {
+                bitboardFlips(bit, player, move);
+            }
+            return move;
+        }
+
+        if (getBoardPlaceValue(position) != 0) {
+            return move;
+        }
+        if (backend == BoardBackend::FLAT) {
+            int index = positionToIndex(position);
+            for (int d = 0; d < DIRECTION_COUNT; ++d) {
+                int count = flatFlipCount(index, player, flatOffsets[d]);
+                move.directionFlips[d] = count;
+                move.flipCount += count;
+            }
+        } else {
+            int d = 0;
+            for (const auto& direction : directions) {
+                int count = findFlippablePieces(position, player, direction);
+                move.directionFlips[d++] = count;
+                move.flipCount += count;
+            }
+        }
+        move.flipMask = flipsToBits(move);
+        return move;
+    }
+
+    // checks if there are valid moves left for the current player
+    //
+    // parameters:
+    // std::stack<PlayerMove>& gameHistory - a stack representing the history of moves in the game
+    // int currentPlayer - the current player's number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // bool - true if there are valid moves left, false otherwise
+    bool areValidMovesLeftForPlayer(
+        std::stack<PlayerMove> &gameHistory,
+        int currentPlayer
+    ) {
+        // by default the move is valid
+        bool validMoves = true;
+
+        // if the board is full
+        if (gameHistory.size() >= maxBoardSize * maxBoardSize) {
+            validMoves = false;
+        }
+
+        // return the boolean
+        return validMoves;
+    }
+
+    // builds one row of the board in ASCII format, 'X', 'O', and '.' for empty spaces
+    //
+    // parameters:
+    // int row - the row, 0 for the top
+    //
+    // returns:
+    // std::string - the row, two characters per square
+    std::string rowText(int row) const {
+        std::string text(2 * maxBoardSize, ' ');
+        for (int col = 0; col < maxBoardSize; ++col) {
+            int value = getBoardPlaceValue({row, col});
+            text[2 * col] = (value == 1) ? 'X' : (value == 2) ? 'O' : '.';
+        }
+        return text;
+    }
+
+    // prints the board in ASCII format, showing 'X', 'O', and '.' for empty spaces
+    // the board is built in one string and written at once
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // void - does not return a value
+    void printBoard() const {
+        std::string text;
+        text.reserve((2 * maxBoardSize + 1) * maxBoardSize);
+        for (int row = 0; row < maxBoardSize; ++row) {
+            text += rowText(row);
+            text += '\n';
+        }
+        std::cout << text;
+    }
+
+    // counts the valid moves of a player, on a bitboard without working out their flips
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // int - the number of valid moves
+    int countValidMoves(int player) const {
+        if (backend == BoardBackend::BITBOARD) {
+            return __builtin_popcountll(bitboardLegalMoves(player));
+        }
+        return getValidMoves(player).size();
+    }
+
+    // counts the pieces a player has on the board
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // int - the number of pieces
+    int countPieces(int player) const {
+        if (backend == BoardBackend::BITBOARD) {
+            // each set bit is one piece
+            return __builtin_popcountll(bitboards[player - 1]);
+        }
+        if (backend == BoardBackend::FLAT) {
+            // the border value never matches a player
+            return std::count(cells.begin(), cells.end(), player);
+        }
+        // NOTE: its more efficent to count both players in one pass
+        // but count is used due to project requirements
+        return std::count_if(board.begin(), board.end(), [player](const auto& pair) {
+            return pair.second.getValue() == player;
+        });
+    }
+
+    // calls visit(row, col, player) for every piece on the board
+    //
+    // parameters:
+    // Visitor visit - called once per piece
+    //
+    // returns:
+    // void - does not return a value
+    template <typename Visitor>
+    void forEachPiece(Visitor visit) const {
+        if (backend == BoardBackend::BITBOARD) {
+            for (int player = 1; player <= 2; ++player) {
+                uint64_t bits = bitboards[player - 1];
+                while (bits) {
+                    int bitIndex = __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    visit(bitIndex / BITBOARD_STRIDE, bitIndex % BITBOARD_STRIDE, player);
+                }
+            }
+        } else if (backend == BoardBackend::FLAT) {
+            for (int row = 0; row < maxBoardSize; ++row) {
+                const uint8_t* cell = &cells[(row + 1) * flatStride + 1];
+                for (int col = 0; col < maxBoardSize; ++col) {
+                    if (cell[col] != 0) {
+                        visit(row, col, static_cast<int>(cell[col]));
+                    }
+                }
+            }
+        } else {
+            for (const auto& pair : board) {
+                int value = pair.second.getValue();
+                if (value != 0) {
+                    visit(pair.first.first, pair.first.second, value);
+                }
+            }
+        }
+    }
+
+    // counts the tokens for each player and displays the winner or if the game is a draw
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // void - does not return a value
+    void showWinner() const {
+        int countX = countPieces(1);
+        int countO = countPieces(2);
+
+        this->printBoard();
+
+        std::string text;
+        // display player X tokens
+        text += "X: ";
+        for (int i = 0; i < countX; ++i) {
+            text += ". ";
+        }
+        text += '\n';
+
+        // display player O tokens
+        text += "O: ";
+        for (int i = 0; i < countO; ++i) {
+            text += ". ";
+        }
+        text += '\n';
+
+        // display the winner or draw
+        if (countX > countO) {
+            text += "Player X wins (" + std::to_string(countX) + "-" + std::to_string(countO) + ")\n";
+        } else if (countO > countX) {
+            text += "Player O wins (" + std::to_string(countO) + "-" + std::to_string(countX) + ")\n";
+        } else {
+            text += "It's a draw (" + std::to_string(countX) + "-" + std::to_string(countO) + ")\n";
+        }
+        std::cout << text << std::flush;
+    }
+
+    // retrieves the maximum size of the board
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // int - the maximum size of the board
+    int getMaxBoardSize() const {
+        return maxBoardSize;
+    }
+
+    // retrieves the storage backend the board is using
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // BoardBackend - the backend
+    BoardBackend getBackend() const {
+        return backend;
+    }
+};
+
+#endif /* BOARD_H */
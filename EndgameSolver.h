@@ -0,0 +1,483 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Exact Endgame Solver
+ *
+ * Near the end of the game the heuristic search is slow (every line is
+ * searched to the same depth) and wrong (a pass is a leaf and the leaves
+ * are estimates). With few enough empty squares the game can be played out
+ * to the end instead. The solver is a negamax alpha-beta search on the
+ * final disc difference (the mover's discs minus the opponent's, empty
+ * squares left when both players pass count for nobody), with passes
+ * played as moves so every line ends with the game.
+ *
+ * Tuned for speed
+ *
+ * - the empty squares are kept in a doubly linked list, taken out and put
+ *   back as moves are made and unmade, so the number of empties and the
+ *   last empty square are known without looking at the board
+ * - the disc difference is updated from each move's flip count, nothing is
+ *   counted at the leaves
+ * - with one empty square left its flips are counted for the player to
+ *   move, then for the opponent, and the score follows from the count, no
+ *   move is made
+ * - the board is split into quadrants and the parity of the empty squares
+ *   in each is kept as a bitmask. Below ENDGAME_MOBILITY_EMPTIES moves in
+ *   a quadrant with an odd number of empties are tried first (the player
+ *   who moves there can usually also take the last square), then corners
+ *   before edges before the rest
+ * - above it, moves are ordered fastest-first: the move leaving the
+ *   opponent the fewest replies is tried first, then by parity
+ * - after the first move the others are searched with a null window
+ *   around the best score so far, and again with the full window only
+ *   when one turns out better
+ * - positions with at least ENDGAME_TABLE_EMPTIES empties are cached in a
+ *   table of bounds that belongs to the thread and keeps its entries
+ *   between solves, since exact results never go stale. It is separate
+ *   from the transposition table, whose scores are on another scale.
+ *
+ * The solver runs on the board type getAIMove searches, a FixedBoard for
+ * the common sizes, and uses its move generation. The solve is given up
+ * when the time runs out, or without a time limit after a number of
+ * nodes, and getAIMove falls back to the heuristic search, so a fixed
+ * depth search never waits on a solve that would take too long.
+ *
+ */
+
+#ifndef ENDGAMESOLVER_H
+#define ENDGAMESOLVER_H
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+// include board implementation
+#include "Board.h"
+
+
+// empty squares at or below which getAIMove solves the game by default,
+// 12 empties solve in well under ENDGAME_DEFAULT_NODES on 8x8
+const int ENDGAME_DEFAULT_EMPTIES = 12;
+// empty squares above which moves are ordered by the opponent's mobility
+const int ENDGAME_MOBILITY_EMPTIES = 5;
+// empty squares from which positions go into the solver's table
+const int ENDGAME_TABLE_EMPTIES = 5;
+// entries in each thread's table, a power of two
+const size_t ENDGAME_TABLE_SIZE = size_t(1) << 18;
+// nodes between clock checks
+const uint64_t ENDGAME_CLOCK_INTERVAL = 4096;
+// nodes a solve without a time limit may visit by default, about 65 ms
+const uint64_t ENDGAME_DEFAULT_NODES = uint64_t(1) << 20;
+
+// a cached endgame result, the exact score lies in [lower, upper]
+struct EndgameEntry {
+    uint64_t key = 0;
+    int16_t lower = 0;
+    int16_t upper = 0;
+    // the square of the best move, -1 if none
+    int16_t bestSquare = -1;
+};
+
+
+// the solver's table of this thread
+//
+// returns:
+// std::vector<EndgameEntry>& - the table, allocated on first use
+inline std::vector<EndgameEntry>& endgameTable() {
+    thread_local std::vector<EndgameEntry> table(ENDGAME_TABLE_SIZE);
+    return table;
+}
+
+// empties the solver's table of this thread, whether a solve finishes
+// within its nodes depends on what the table holds
+//
+// returns:
+// void - does not return a value
+inline void clearEndgameTable() {
+    std::fill(endgameTable().begin(), endgameTable().end(), EndgameEntry());
+}
+
+
+template <typename BoardType>
+class EndgameSolver {
+private:
+    BoardType& board;
+    int boardSize;
+    int squareCount;
+
+    // the empty squares as a doubly linked list, index squareCount is the head
+    std::vector<int> nextEmpty;
+    std::vector<int> prevEmpty;
+    int empties = 0;
+    // the quadrant of each square, and a bit per quadrant with an odd number of empties
+    std::vector<uint8_t> quadrant;
+    uint32_t parity = 0;
+    // corners 2, other edges 1, the rest 0
+    std::vector<uint8_t> squareClass;
+    // mixed into the table keys so boards of different sizes don't share entries
+    uint64_t sizeKey;
+
+    bool timed = false;
+    bool stopped = false;
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t nodes = 0;
+    // 0 for no limit
+    uint64_t nodeLimit = 0;
+
+    // takes a square out of the empty list
+    //
+    // parameters:
+    // int square - the square a move was played on
+    //
+    // returns:
+    // void - does not return a value
+    void removeEmpty(int square) {
+        nextEmpty[prevEmpty[square]] = nextEmpty[square];
+        prevEmpty[nextEmpty[square]] = prevEmpty[square];
+        parity ^= 1u << quadrant[square];
+        --empties;
+    }
+
+    // puts a square back into the empty list, in reverse order of removeEmpty
+    //
+    // parameters:
+    // int square - the square of the move taken back
+    //
+    // returns:
+    // void - does not return a value
+    void restoreEmpty(int square) {
+        nextEmpty[prevEmpty[square]] = square;
+        prevEmpty[nextEmpty[square]] = square;
+        parity ^= 1u << quadrant[square];
+        ++empties;
+    }
+
+    // counts the pieces a move on an empty square would flip, without making it
+    //
+    // parameters:
+    // int square - the empty square
+    // int player - the player who would move there
+    //
+    // returns:
+    // int - the pieces flipped, 0 if the move isn't valid
+    int countFlips(int square, int player) const {
+        int opponent = (player == 1) ? 2 : 1;
+        int row = square / boardSize;
+        int col = square % boardSize;
+        int flips = 0;
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int r = row + DIRECTION_ROWS[d];
+            int c = col + DIRECTION_COLS[d];
+            int run = 0;
+            while (r >= 0 && r < boardSize && c >= 0 && c < boardSize &&
+                   board.getBoardPlaceValue({r, c}) == opponent) {
+                ++run;
+                r += DIRECTION_ROWS[d];
+                c += DIRECTION_COLS[d];
+            }
+            if (run > 0 && r >= 0 && r < boardSize && c >= 0 && c < boardSize &&
+                board.getBoardPlaceValue({r, c}) == player) {
+                flips += run;
+            }
+        }
+        return flips;
+    }
+
+    // scores the position with one empty square left
+    //
+    // parameters:
+    // int player - the player to move
+    // int discDifference - the player's discs minus the opponent's
+    //
+    // returns:
+    // int - the final disc difference from the player's point of view
+    int lastEmptyScore(int player, int discDifference) const {
+        int square = nextEmpty[squareCount];
+        int flips = countFlips(square, player);
+        if (flips > 0) {
+            return discDifference + 1 + 2 * flips;
+        }
+        // the player passes, the opponent may still take it
+        flips = countFlips(square, (player == 1) ? 2 : 1);
+        if (flips > 0) {
+            return discDifference - 1 - 2 * flips;
+        }
+        return discDifference;
+    }
+
+    // sorts the moves so the likely best come first
+    //
+    // parameters:
+    // MoveList& moves - the moves to sort
+    // int player - the player to move
+    // int tableSquare - the best move cached in the table, -1 if none
+    //
+    // returns:
+    // void - does not return a value
+    void orderEndgameMoves(MoveList& moves, int player, int tableSquare) {
+        int opponent = (player == 1) ? 2 : 1;
+        // higher is searched first
+        InlineBuffer<int, MoveList::INLINE_CAPACITY> priorities;
+        for (int i = 0; i < moves.size(); ++i) {
+            const Move& move = moves[i];
+            int square = move.row * boardSize + move.col;
+            int priority = squareClass[square];
+            if (parity & (1u << quadrant[square])) {
+                priority += 4;
+            }
+            if (empties > ENDGAME_MOBILITY_EMPTIES) {
+                board.placePiece(move, player);
+                priority += (boardSize * boardSize - board.countValidMoves(opponent)) * 8;
+                board.undoMove(move, player);
+            }
+            if (square == tableSquare) {
+                priority += 1 << 24;
+            }
+            priorities.append() = priority;
+        }
+
+        for (int i = 1; i < moves.size(); ++i) {
+            Move current = moves[i];
+            int currentPriority = priorities[i];
+            int j = i - 1;
+            while (j >= 0 && priorities[j] < currentPriority) {
+                moves[j + 1] = moves[j];
+                priorities[j + 1] = priorities[j];
+                --j;
+            }
+            moves[j + 1] = current;
+            priorities[j + 1] = currentPriority;
+        }
+    }
+
+    // counts a node and checks the clock every ENDGAME_CLOCK_INTERVAL nodes
+    //
+    // returns:
+    // bool - true once the time or the nodes are used up
+    bool visitNode() {
+        ++nodes;
+        if (!stopped && nodes % ENDGAME_CLOCK_INTERVAL == 0 &&
+            ((nodeLimit > 0 && nodes >= nodeLimit) ||
+             (timed && std::chrono::steady_clock::now() >= deadline))) {
+            stopped = true;
+        }
+        return stopped;
+    }
+
+    // solves a position
+    //
+    // parameters:
+    // int player - the player to move
+    // int alpha - the score the player to move is already guaranteed
+    // int beta - the score the opponent will not allow
+    // int discDifference - the player's discs minus the opponent's
+    // bool passed - true if the opponent just passed
+    //
+    // returns:
+    // int - the final disc difference from the player's point of view, a
+    //       bound on it outside (alpha, beta), 0 once stopped
+    int solve(int player, int alpha, int beta, int discDifference, bool passed) {
+        if (visitNode()) {
+            return 0;
+        }
+        if (empties == 0) {
+            return discDifference;
+        }
+        if (empties == 1) {
+            return lastEmptyScore(player, discDifference);
+        }
+        int opponent = (player == 1) ? 2 : 1;
+
+        MoveList moves = board.getValidMoves(player);
+        if (moves.empty()) {
+            // neither player can move, the game is over
+            if (passed) {
+                return discDifference;
+            }
+            return -solve(opponent, -beta, -alpha, -discDifference, true);
+        }
+
+        // the table decides the window or gives the move to try first
+        EndgameEntry* entry = nullptr;
+        uint64_t key = 0;
+        int tableSquare = -1;
+        if (empties >= ENDGAME_TABLE_EMPTIES) {
+            key = board.getHash() ^ zobristSideKey(player) ^ sizeKey;
+            entry = &endgameTable()[splitMix64(key) & (ENDGAME_TABLE_SIZE - 1)];
+            if (entry->key == key) {
+                if (entry->lower >= beta || entry->lower == entry->upper) {
+                    return entry->lower;
+                }
+                if (entry->upper <= alpha) {
+                    return entry->upper;
+                }
+                tableSquare = entry->bestSquare;
+            }
+        }
+
+        orderEndgameMoves(moves, player, tableSquare);
+        int originalAlpha = alpha;
+        int bestScore = -(squareCount + 1);
+        int bestSquare = -1;
+        for (const auto& move : moves) {
+            int square = move.row * boardSize + move.col;
+            board.placePiece(move, player);
+            removeEmpty(square);
+            int childDifference = -(discDifference + 1 + 2 * move.flipCount);
+            int score;
+            if (bestSquare < 0) {
+                score = -solve(opponent, -beta, -alpha, childDifference, false);
+            } else {
+                // the first move is most likely the best, the rest only have to be shown worse
+                score = -solve(opponent, -alpha - 1, -alpha, childDifference, false);
+                if (score > alpha && score < beta) {
+                    score = -solve(opponent, -beta, -score, childDifference, false);
+                }
+            }
+            restoreEmpty(square);
+            board.undoMove(move, player);
+            if (stopped) {
+                return 0;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                bestSquare = square;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (entry) {
+            // a fresh position replaces whatever was in the slot
+            if (entry->key != key) {
+                entry->key = key;
+                entry->lower = static_cast<int16_t>(-(squareCount + 1));
+                entry->upper = static_cast<int16_t>(squareCount + 1);
+            }
+            if (bestScore <= originalAlpha) {
+                entry->upper = static_cast<int16_t>(bestScore);
+            } else if (bestScore >= beta) {
+                entry->lower = static_cast<int16_t>(bestScore);
+            } else {
+                entry->lower = entry->upper = static_cast<int16_t>(bestScore);
+            }
+            entry->bestSquare = static_cast<int16_t>(bestSquare);
+        }
+        return bestScore;
+    }
+
+public:
+    // prepares to solve the position on a board
+    //
+    // parameters:
+    // BoardType& board - the board, changed while solving and restored after
+    // int timeLimitMs - the time allowed, 0 for no limit
+    // uint64_t maxNodes - the nodes allowed, 0 for no limit
+    EndgameSolver(BoardType& gameBoard, int timeLimitMs, uint64_t maxNodes = 0)
+        : board(gameBoard),
+          boardSize(gameBoard.getMaxBoardSize()),
+          squareCount(boardSize * boardSize),
+          nextEmpty(squareCount + 1),
+          prevEmpty(squareCount + 1),
+          quadrant(squareCount),
+          squareClass(squareCount),
+          sizeKey(splitMix64(~uint64_t(boardSize))),
+          nodeLimit(maxNodes) {
+        int last = boardSize - 1;
+        int half = boardSize / 2;
+        int tail = squareCount;
+        nextEmpty[tail] = prevEmpty[tail] = tail;
+        for (int row = 0; row < boardSize; ++row) {
+            for (int col = 0; col < boardSize; ++col) {
+                int square = row * boardSize + col;
+                quadrant[square] = static_cast<uint8_t>((row >= half) * 2 + (col >= half));
+                bool rowEdge = (row == 0 || row == last);
+                bool colEdge = (col == 0 || col == last);
+                squareClass[square] = static_cast<uint8_t>((rowEdge && colEdge) ? 2 : (rowEdge || colEdge) ? 1 : 0);
+                if (board.getBoardPlaceValue({row, col}) == 0) {
+                    // append to the end of the list
+                    nextEmpty[square] = squareCount;
+                    prevEmpty[square] = prevEmpty[squareCount];
+                    nextEmpty[prevEmpty[squareCount]] = square;
+                    prevEmpty[squareCount] = square;
+                    parity ^= 1u << quadrant[square];
+                    ++empties;
+                }
+            }
+        }
+        if (timeLimitMs > 0) {
+            timed = true;
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimitMs);
+        }
+    }
+
+    // finds the move with the best final disc difference
+    //
+    // parameters:
+    // int player - the player to move, who must have a valid move
+    // std::pair<int, int>& bestMove - set to the best move
+    // int& bestScore - set to its exact final disc difference
+    //
+    // returns:
+    // bool - true if solved, false if the time or the nodes ran out first
+    bool solveRoot(int player, std::pair<int, int>& bestMove, int& bestScore) {
+        int opponent = (player == 1) ? 2 : 1;
+        int discDifference = board.countPieces(player) - board.countPieces(opponent);
+        MoveList moves = board.getValidMoves(player);
+        if (moves.empty()) {
+            return false;
+        }
+        orderEndgameMoves(moves, player, -1);
+
+        int alpha = -(squareCount + 1);
+        int beta = squareCount + 1;
+        bestScore = alpha;
+        for (const auto& move : moves) {
+            int square = move.row * boardSize + move.col;
+            board.placePiece(move, player);
+            removeEmpty(square);
+            int childDifference = -(discDifference + 1 + 2 * move.flipCount);
+            int score = -solve(opponent, -alpha - 1, -alpha, childDifference, false);
+            if (score > alpha) {
+                score = -solve(opponent, -beta, -score, childDifference, false);
+            }
+            restoreEmpty(square);
+            board.undoMove(move, player);
+            if (stopped) {
+                return false;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                bestMove = move.position();
+                alpha = std::max(alpha, score);
+            }
+        }
+        return true;
+    }
+
+    // retrieves the nodes visited
+    //
+    // returns:
+    // uint64_t - the positions solve was called on
+    uint64_t getNodes() const {
+        return nodes;
+    }
+
+    // retrieves the number of empty squares
+    //
+    // returns:
+    // int - the empty squares on the board
+    int getEmpties() const {
+        return empties;
+    }
+};
+
+#endif /* ENDGAMESOLVER_H */
@@ -0,0 +1,386 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Position Evaluation
+ *
+ * The search scores a move as evaluator.moveScore(move) minus the
+ * opponent's best reply, and a leaf (depth reached, or no moves) as
+ * evaluator.evaluate(board, player, validMoves), always from the point of
+ * view of the player to move.
+ *
+ * An evaluator is any class with these members, the search is a template
+ * on it so the calls inline, there is no virtual dispatch per node
+ *
+ *   void reset(const BoardType& board)  - called once on the root position
+ *   int moveScore(const Move& move)     - added to a move's score
+ *   void place(const Move& move, int player)
+ *   void undo(const Move& move, int player)
+ *                                       - called after the search makes and
+ *                                         before it unmakes a move, so the
+ *                                         evaluator can keep incremental state
+ *   int evaluate(const BoardType& board, int player, const MoveList& validMoves)
+ *                                       - the leaf score
+ *
+ * Each search thread needs its own copy since place/undo change it. To add
+ * one, give it an EvaluatorKind and a case in withEvaluator.
+ *
+ * FLIPS      - the original scoring: a move is worth the pieces it flips
+ *              and leaves are 0
+ * POSITIONAL - leaves are scored by square weights (corners good, the
+ *              squares next to them bad), mobility, stable edge discs
+ *              and parity, a finished game by who won. Moves add nothing.
+ *              The square weights, disc difference and empty count are
+ *              kept up to date by place/undo, only mobility and stability
+ *              are looked at per leaf.
+ * NTUPLE     - leaves are scored by the pattern weights in a memory mapped
+ *              file (see NTupleWeights.h), a finished game like POSITIONAL.
+ *              On a board of another size than the weights it falls back
+ *              to POSITIONAL.
+ *
+ * Scores go into the transposition table as 24 bit values, inside
+ * +-TT_SCORE_MAX (about 8.4 million). A score past that is stored
+ * saturated as the bound it still proves, so no evaluator has to keep its
+ * scores small. A table shouldn't be shared by searches with different
+ * evaluators.
+ *
+ */
+
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <algorithm>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+// include n-tuple weights implementation
+#include "NTupleWeights.h"
+
+
+// which evaluator the search uses
+enum class EvaluatorKind {
+    FLIPS,
+    POSITIONAL,
+    NTUPLE
+};
+
+// weights of the positional evaluator
+const int EVAL_CORNER_WEIGHT = 20;
+// the square diagonally next to a corner
+const int EVAL_X_SQUARE_WEIGHT = -8;
+// the edge squares next to a corner
+const int EVAL_C_SQUARE_WEIGHT = -4;
+const int EVAL_EDGE_WEIGHT = 2;
+const int EVAL_MOBILITY_WEIGHT = 3;
+const int EVAL_STABLE_WEIGHT = 5;
+const int EVAL_PARITY_WEIGHT = 2;
+// score of a won game, plus the disc difference, larger than any other evaluation
+const int EVAL_WIN_SCORE = 20000;
+
+
+// the original scoring, the pieces each move flips
+class FlipEvaluator {
+public:
+    template <typename BoardType>
+    void reset(const BoardType&) {}
+
+    int moveScore(const Move& move) const {
+        return move.flipCount;
+    }
+
+    void place(const Move&, int) {}
+
+    void undo(const Move&, int) {}
+
+    template <typename BoardType>
+    int evaluate(const BoardType&, int, const MoveList&) const {
+        return 0;
+    }
+};
+
+
+// square weights, mobility, stable edge discs and parity
+class PositionalEvaluator {
+private:
+    int boardSize = 0;
+    // sum of the square weights, X's minus O's
+    int squareScore = 0;
+    // X's discs minus O's discs
+    int discDifference = 0;
+    int emptySquares = 0;
+
+    // the static weight of a square
+    //
+    // parameters:
+    // int row - the row of the square
+    // int col - the column of the square
+    //
+    // returns:
+    // int - the weight
+    int squareWeight(int row, int col) const {
+        int last = boardSize - 1;
+        // distance to the nearest edge in each axis
+        int rowDistance = std::min(row, last - row);
+        int colDistance = std::min(col, last - col);
+        if (rowDistance == 0 && colDistance == 0) {
+            return EVAL_CORNER_WEIGHT;
+        }
+        if (rowDistance == 1 && colDistance == 1) {
+            return EVAL_X_SQUARE_WEIGHT;
+        }
+        if (rowDistance + colDistance == 1) {
+            return EVAL_C_SQUARE_WEIGHT;
+        }
+        if (rowDistance == 0 || colDistance == 0) {
+            return EVAL_EDGE_WEIGHT;
+        }
+        return 0;
+    }
+
+    // the change in squareScore and discDifference a move makes, from X's view
+    //
+    // parameters:
+    // const Move& move - the move
+    // int player - the player who plays it
+    // int& squareDelta - set to the square score change
+    // int& discDelta - set to the disc difference change
+    //
+    // returns:
+    // void - does not return a value
+    void moveDelta(const Move& move, int player, int& squareDelta, int& discDelta) const {
+        // a flipped square goes from -weight to +weight for the mover
+        int weights = squareWeight(move.row, move.col);
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int row = move.row;
+            int col = move.col;
+            for (int i = 0; i < move.directionFlips[d]; ++i) {
+                row += DIRECTION_ROWS[d];
+                col += DIRECTION_COLS[d];
+                weights += 2 * squareWeight(row, col);
+            }
+        }
+        int sign = (player == 1) ? 1 : -1;
+        squareDelta = sign * weights;
+        discDelta = sign * (1 + 2 * move.flipCount);
+    }
+
+    // counts the discs that can never flip because they're connected to a
+    // corner along an edge by discs of the same color
+    //
+    // parameters:
+    // const BoardType& board - the board
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // int - the number of stable edge discs
+    template <typename BoardType>
+    int stableEdgeDiscs(const BoardType& board, int player) const {
+        int last = boardSize - 1;
+        // each edge from one corner to the other
+        const int edges[4][4] = {
+            {0, 0, 0, 1}, {last, 0, 0, 1}, {0, 0, 1, 0}, {0, last, 1, 0}
+        };
+        int stable = 0;
+        for (const auto& edge : edges) {
+            auto valueAt = [&](int i) {
+                return board.getBoardPlaceValue({edge[0] + i * edge[2], edge[1] + i * edge[3]});
+            };
+            // the run from the first corner
+            int fromStart = 0;
+            while (fromStart < boardSize && valueAt(fromStart) == player) {
+                ++fromStart;
+            }
+            if (fromStart == boardSize) {
+                stable += boardSize;
+                continue;
+            }
+            // the run from the other corner
+            int fromEnd = 0;
+            while (fromEnd < boardSize && valueAt(last - fromEnd) == player) {
+                ++fromEnd;
+            }
+            stable += fromStart + fromEnd;
+        }
+        // every corner was counted by both of its edges
+        const int corners[4][2] = {{0, 0}, {0, last}, {last, 0}, {last, last}};
+        for (const auto& corner : corners) {
+            if (board.getBoardPlaceValue({corner[0], corner[1]}) == player) {
+                --stable;
+            }
+        }
+        return stable;
+    }
+
+public:
+    template <typename BoardType>
+    void reset(const BoardType& board) {
+        boardSize = board.getMaxBoardSize();
+        squareScore = 0;
+        discDifference = 0;
+        emptySquares = 0;
+        for (int row = 0; row < boardSize; ++row) {
+            for (int col = 0; col < boardSize; ++col) {
+                int value = board.getBoardPlaceValue({row, col});
+                int sign = (value == 1) ? 1 : (value == 2) ? -1 : 0;
+                squareScore += sign * squareWeight(row, col);
+                discDifference += sign;
+                emptySquares += (value == 0);
+            }
+        }
+    }
+
+    int moveScore(const Move&) const {
+        return 0;
+    }
+
+    void place(const Move& move, int player) {
+        int squareDelta;
+        int discDelta;
+        moveDelta(move, player, squareDelta, discDelta);
+        squareScore += squareDelta;
+        discDifference += discDelta;
+        --emptySquares;
+    }
+
+    void undo(const Move& move, int player) {
+        int squareDelta;
+        int discDelta;
+        moveDelta(move, player, squareDelta, discDelta);
+        squareScore -= squareDelta;
+        discDifference -= discDelta;
+        ++emptySquares;
+    }
+
+    // scores a leaf
+    //
+    // parameters:
+    // const BoardType& board - the position
+    // int player - the player to move
+    // const MoveList& validMoves - the player's valid moves
+    //
+    // returns:
+    // int - the score from the player's point of view
+    template <typename BoardType>
+    int evaluate(const BoardType& board, int player, const MoveList& validMoves) const {
+        int opponent = (player == 1) ? 2 : 1;
+        int sign = (player == 1) ? 1 : -1;
+        int ownMoves = validMoves.size();
+        int opponentMoves = board.countValidMoves(opponent);
+
+        // neither player can move, the game is over
+        if (ownMoves == 0 && opponentMoves == 0) {
+            int discs = sign * discDifference;
+            return (discs > 0) ? EVAL_WIN_SCORE + discs : (discs < 0) ? -EVAL_WIN_SCORE + discs : 0;
+        }
+
+        int score = sign * squareScore;
+        score += EVAL_MOBILITY_WEIGHT * (ownMoves - opponentMoves);
+        score += EVAL_STABLE_WEIGHT * (stableEdgeDiscs(board, player) - stableEdgeDiscs(board, opponent));
+        // with an odd number of empty squares the player to move gets the last one
+        score += (emptySquares % 2 == 1) ? EVAL_PARITY_WEIGHT : -EVAL_PARITY_WEIGHT;
+        return score;
+    }
+};
+
+
+// the pattern weights, or the positional evaluator when the board doesn't match them
+class NTupleEvaluator {
+private:
+    const NTupleWeights* weights;
+    bool useWeights = false;
+    PositionalEvaluator fallback;
+
+public:
+    explicit NTupleEvaluator(const NTupleWeights* ntupleWeights) : weights(ntupleWeights) {}
+
+    template <typename BoardType>
+    void reset(const BoardType& board) {
+        useWeights = weights->getBoardSize() == board.getMaxBoardSize();
+        if (!useWeights) {
+            fallback.reset(board);
+        }
+    }
+
+    int moveScore(const Move&) const {
+        return 0;
+    }
+
+    void place(const Move& move, int player) {
+        if (!useWeights) {
+            fallback.place(move, player);
+        }
+    }
+
+    void undo(const Move& move, int player) {
+        if (!useWeights) {
+            fallback.undo(move, player);
+        }
+    }
+
+    // scores a leaf
+    //
+    // parameters:
+    // const BoardType& board - the position
+    // int player - the player to move
+    // const MoveList& validMoves - the player's valid moves
+    //
+    // returns:
+    // int - the score from the player's point of view
+    template <typename BoardType>
+    int evaluate(const BoardType& board, int player, const MoveList& validMoves) const {
+        if (!useWeights) {
+            return fallback.evaluate(board, player, validMoves);
+        }
+
+        int opponent = (player == 1) ? 2 : 1;
+        // neither player can move, the game is over
+        if (validMoves.empty() && board.countValidMoves(opponent) == 0) {
+            int discs = board.countPieces(player) - board.countPieces(opponent);
+            return (discs > 0) ? EVAL_WIN_SCORE + discs : (discs < 0) ? -EVAL_WIN_SCORE + discs : 0;
+        }
+        // keep the sum of the weights below a won game
+        return std::max(-EVAL_WIN_SCORE + 1, std::min(EVAL_WIN_SCORE - 1, weights->score(board, player)));
+    }
+};
+
+
+// calls the visitor with a fresh evaluator of the requested kind
+//
+// parameters:
+// EvaluatorKind kind - the evaluator to create
+// const NTupleWeights* ntupleWeights - the weights for NTUPLE, may be nullptr for the others
+// Visitor&& visitor - a generic lambda taking the evaluator by reference
+//
+// returns:
+// void - does not return a value
+//
+// throws:
+// std::invalid_argument if NTUPLE is asked for without weights
+
+template <typename Visitor>
+inline void withEvaluator(EvaluatorKind kind, const NTupleWeights* ntupleWeights, Visitor&& visitor) {
+    switch (kind) {
+        case EvaluatorKind::FLIPS: {
+            FlipEvaluator evaluator;
+            visitor(evaluator);
+            return;
+        }
+        case EvaluatorKind::POSITIONAL: {
+            PositionalEvaluator evaluator;
+            visitor(evaluator);
+            return;
+        }
+        case EvaluatorKind::NTUPLE: {
+            if (!ntupleWeights) {
+                throw std::invalid_argument("The n-tuple evaluator needs a weights file.");
+            }
+            NTupleEvaluator evaluator(ntupleWeights);
+            visitor(evaluator);
+            return;
+        }
+    }
+}
+
+#endif /* EVALUATOR_H */
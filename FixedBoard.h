@@ -0,0 +1,657 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Fixed Size Board Implementation
+ *
+ * FixedBoard<N> is a board whose size is a template parameter, used by the
+ * AI search for the common sizes 6, 8, 10 and 12. With the size known at
+ * compile time every loop bound, stride, direction offset and wrap mask is
+ * a constant, and the storage is picked per size
+ *
+ * N <= 8 - two uint64_t bitboards (stride 8, same layout as Board's
+ *          BITBOARD backend), the legal moves and the flips are the same
+ *          per direction shifts, with the direction a template parameter
+ *          so every shift and mask is an immediate
+ * N > 8  - a padded std::array of (N + 2) x (N + 2) cells with a border
+ *          ring and a frontier of the empty squares next to a piece, like
+ *          Board's FLAT backend but with constexpr offsets and no heap
+ *          allocation, copying it is a plain memcpy
+ *
+ * A FixedBoard only has the operations the search needs (move generation,
+ * place/undo, counting, the zobrist key). Moves are the same Move structs
+ * Board generates, in the same row-major order, and the zobrist key is
+ * computed the same way, so a FixedBoard built from a Board searches to
+ * the same result and shares transposition table entries with it.
+ *
+ * withFixedBoard is the runtime dispatcher: it copies a Board into the
+ * FixedBoard for its size and calls a generic lambda with it, or returns
+ * false if the size has no specialization.
+ *
+ */
+
+#ifndef FIXEDBOARD_H
+#define FIXEDBOARD_H
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+
+
+template <int N>
+class FixedBoard {
+public:
+    static constexpr int SIZE = N;
+    // storage is picked by size
+    static constexpr bool USES_BITBOARD = N <= BITBOARD_STRIDE;
+
+private:
+    static_assert(N >= 4, "Board size must be at least 4.");
+
+    // padded flat layout
+    static constexpr int FLAT_STRIDE = N + 2;
+    static constexpr int FLAT_CELLS = FLAT_STRIDE * FLAT_STRIDE;
+
+    // index offset of each direction in the padded layout
+    static constexpr std::array<int, DIRECTION_COUNT> makeFlatOffsets() {
+        std::array<int, DIRECTION_COUNT> offsets{};
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            offsets[d] = DIRECTION_ROWS[d] * FLAT_STRIDE + DIRECTION_COLS[d];
+        }
+        return offsets;
+    }
+
+    // square index offset of each direction (row * N + col)
+    static constexpr std::array<int, DIRECTION_COUNT> makeSquareOffsets() {
+        std::array<int, DIRECTION_COUNT> offsets{};
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            offsets[d] = DIRECTION_ROWS[d] * N + DIRECTION_COLS[d];
+        }
+        return offsets;
+    }
+
+    // bitboard mask of the squares on the board
+    static constexpr uint64_t makeSquareMask() {
+        uint64_t mask = 0;
+        if (USES_BITBOARD) {
+            for (int row = 0; row < N; ++row) {
+                for (int col = 0; col < N; ++col) {
+                    mask |= uint64_t(1) << (row * BITBOARD_STRIDE + col);
+                }
+            }
+        }
+        return mask;
+    }
+
+    // bitboard squares whose neighbour in each direction is still on the board
+    static constexpr std::array<uint64_t, DIRECTION_COUNT> makeShiftMasks() {
+        std::array<uint64_t, DIRECTION_COUNT> masks{};
+        if (USES_BITBOARD) {
+            for (int d = 0; d < DIRECTION_COUNT; ++d) {
+                for (int row = 0; row < N; ++row) {
+                    for (int col = 0; col < N; ++col) {
+                        int r = row + DIRECTION_ROWS[d];
+                        int c = col + DIRECTION_COLS[d];
+                        if (r >= 0 && r < N && c >= 0 && c < N) {
+                            masks[d] |= uint64_t(1) << (row * BITBOARD_STRIDE + col);
+                        }
+                    }
+                }
+            }
+        }
+        return masks;
+    }
+
+    static constexpr std::array<int, DIRECTION_COUNT> FLAT_OFFSETS = makeFlatOffsets();
+    static constexpr std::array<int, DIRECTION_COUNT> SQUARE_OFFSETS = makeSquareOffsets();
+    static constexpr uint64_t SQUARE_MASK = makeSquareMask();
+    static constexpr std::array<uint64_t, DIRECTION_COUNT> SHIFT_MASKS = makeShiftMasks();
+
+    // words of the frontier, one bit per padded square
+    static constexpr int FRONTIER_WORDS = USES_BITBOARD ? 1 : (FLAT_CELLS + 63) / 64;
+
+    // one mask per player when N <= 8
+    uint64_t bitboards[2];
+    // padded squares when N > 8, 0 empty, 1 X, 2 O, BORDER_SQUARE off the board
+    std::array<uint8_t, USES_BITBOARD ? 1 : FLAT_CELLS> cells;
+    // pieces next to each padded square when N > 8
+    std::array<uint8_t, USES_BITBOARD ? 1 : FLAT_CELLS> occupiedNeighbours;
+    // the empty squares next to a piece when N > 8, the only squares that can be moves
+    std::array<uint64_t, FRONTIER_WORDS> frontier;
+    // zobrist key of the pieces, same keys as Board
+    uint64_t zobristHash;
+
+    // shifts a bitboard one square in direction D, the bits have to be masked first
+    template <int D>
+    static uint64_t shiftLine(uint64_t bits) {
+        constexpr int shift = BITBOARD_SHIFTS[D];
+        return (shift > 0) ? (bits << shift) : (bits >> (-shift & 63));
+    }
+
+    // the empty squares that are legal moves in direction D
+    // every piece of a run but the last has a neighbour on the board that way,
+    // so masking the opponent once keeps the whole walk from wrapping
+    template <int D>
+    static uint64_t legalLine(uint64_t own, uint64_t opponent, uint64_t empty) {
+        uint64_t inner = opponent & SHIFT_MASKS[D];
+        uint64_t line = shiftLine<D>(own & SHIFT_MASKS[D]) & inner;
+        // a line is at most N - 2 pieces long
+        for (int i = 0; i < N - 3; ++i) {
+            line |= shiftLine<D>(line) & inner;
+        }
+        return shiftLine<D>(line) & empty;
+    }
+
+    // every empty square where the player has a legal move
+    uint64_t bitboardLegalMoves(int player) const {
+        uint64_t own = bitboards[player - 1];
+        uint64_t opponent = bitboards[2 - player];
+        uint64_t empty = SQUARE_MASK & ~(own | opponent);
+        return legalLine<0>(own, opponent, empty) | legalLine<1>(own, opponent, empty) |
+               legalLine<2>(own, opponent, empty) | legalLine<3>(own, opponent, empty) |
+               legalLine<4>(own, opponent, empty) | legalLine<5>(own, opponent, empty) |
+               legalLine<6>(own, opponent, empty) | legalLine<7>(own, opponent, empty);
+    }
+
+    // walks direction D from a move for bitboardFlips, the pieces are counted
+    // as they're walked (without -mpopcnt a popcount is a library call)
+    template <int D>
+    static void bitboardFlipLine(uint64_t moveBit, uint64_t own, uint64_t opponent, Move& move, uint64_t& flips) {
+        uint64_t line = 0;
+        int count = 0;
+        uint64_t next = shiftLine<D>(moveBit & SHIFT_MASKS[D]);
+        uint64_t inner = opponent & SHIFT_MASKS[D];
+        // walk over the opponents pieces that don't end at the edge
+        while (next & inner) {
+            line |= next;
+            ++count;
+            next = shiftLine<D>(next);
+        }
+        // only flip if the line is anchored by our own piece
+        if (!(next & own)) {
+            line = 0;
+            count = 0;
+        }
+        move.directionFlips[D] = static_cast<uint8_t>(count);
+        move.flipCount += count;
+        flips |= line;
+    }
+
+    // fills in the flips of a bitboard move
+    void bitboardFlips(uint64_t moveBit, int player, Move& move) const {
+        uint64_t own = bitboards[player - 1];
+        uint64_t opponent = bitboards[2 - player];
+        uint64_t flips = 0;
+        move.flipCount = 0;
+        bitboardFlipLine<0>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<1>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<2>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<3>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<4>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<5>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<6>(moveBit, own, opponent, move, flips);
+        bitboardFlipLine<7>(moveBit, own, opponent, move, flips);
+        move.flipMask = flips;
+    }
+
+    // counts the opponent pieces flipped walking direction D from an index, the border stops the walk
+    template <int D>
+    void flatFlipLine(int index, int player, Move& move) const {
+        constexpr int offset = FLAT_OFFSETS[D];
+        int opponent = player ^ 3;
+        int count = 0;
+        index += offset;
+        while (cells[index] == opponent) {
+            ++count;
+            index += offset;
+        }
+        if (cells[index] != player) {
+            count = 0;
+        }
+        move.directionFlips[D] = static_cast<uint8_t>(count);
+        move.flipCount += count;
+    }
+
+    // fills in the flips of a move on the padded board
+    void flatFlips(int index, int player, Move& move) const {
+        move.flipCount = 0;
+        flatFlipLine<0>(index, player, move);
+        flatFlipLine<1>(index, player, move);
+        flatFlipLine<2>(index, player, move);
+        flatFlipLine<3>(index, player, move);
+        flatFlipLine<4>(index, player, move);
+        flatFlipLine<5>(index, player, move);
+        flatFlipLine<6>(index, player, move);
+        flatFlipLine<7>(index, player, move);
+    }
+
+    // checks if a move on the padded board flips anything, stopping at the first direction that does
+    bool flatFlanks(int index, int player) const {
+        int opponent = player ^ 3;
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int next = index + FLAT_OFFSETS[d];
+            if (cells[next] != opponent) {
+                continue;
+            }
+            do {
+                next += FLAT_OFFSETS[d];
+            } while (cells[next] == opponent);
+            if (cells[next] == player) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // updates the frontier after a piece was put on a padded square
+    void occupyFrontier(int index) {
+        frontier[index >> 6] &= ~(uint64_t(1) << (index & 63));
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int neighbour = index + FLAT_OFFSETS[d];
+            if (++occupiedNeighbours[neighbour] == 1 && cells[neighbour] == 0) {
+                frontier[neighbour >> 6] |= uint64_t(1) << (neighbour & 63);
+            }
+        }
+    }
+
+    // updates the frontier after a padded square was emptied
+    void vacateFrontier(int index) {
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            int neighbour = index + FLAT_OFFSETS[d];
+            if (--occupiedNeighbours[neighbour] == 0) {
+                frontier[neighbour >> 6] &= ~(uint64_t(1) << (neighbour & 63));
+            }
+        }
+        if (occupiedNeighbours[index] > 0) {
+            frontier[index >> 6] |= uint64_t(1) << (index & 63);
+        }
+    }
+
+    // index of a position in the padded layout
+    static int flatIndex(int row, int col) {
+        return (row + 1) * FLAT_STRIDE + col + 1;
+    }
+
+    // flips the pieces recorded in the move and updates the zobrist key
+    // its own inverse, so placePiece and undoMove share it
+    void toggleFlips(const Move& move) {
+        int square = move.row * N + move.col;
+        if (USES_BITBOARD) {
+            bitboards[0] ^= move.flipMask;
+            bitboards[1] ^= move.flipMask;
+            uint64_t flips = move.flipMask;
+            while (flips) {
+                int bitIndex = __builtin_ctzll(flips);
+                flips &= flips - 1;
+                zobristHash ^= zobristFlipKey((bitIndex / BITBOARD_STRIDE) * N + bitIndex % BITBOARD_STRIDE);
+            }
+            return;
+        }
+
+        int index = flatIndex(move.row, move.col);
+        toggleFlipLine<0>(move, index, square);
+        toggleFlipLine<1>(move, index, square);
+        toggleFlipLine<2>(move, index, square);
+        toggleFlipLine<3>(move, index, square);
+        toggleFlipLine<4>(move, index, square);
+        toggleFlipLine<5>(move, index, square);
+        toggleFlipLine<6>(move, index, square);
+        toggleFlipLine<7>(move, index, square);
+    }
+
+    // flips the run of a move in direction D on the padded board
+    template <int D>
+    void toggleFlipLine(const Move& move, int index, int square) {
+        for (int i = 0; i < move.directionFlips[D]; ++i) {
+            index += FLAT_OFFSETS[D];
+            square += SQUARE_OFFSETS[D];
+            cells[index] ^= 3; // flip between 1 and 2
+            zobristHash ^= zobristFlipKey(square);
+        }
+    }
+
+    // sets or clears a square without flipping anything, the key is updated
+    void setSquare(int row, int col, int value) {
+        int square = row * N + col;
+        int previous = getBoardPlaceValue({row, col});
+        if (previous != 0) {
+            zobristHash ^= zobristKey(square, previous);
+        }
+        if (USES_BITBOARD) {
+            uint64_t bit = uint64_t(1) << (row * BITBOARD_STRIDE + col);
+            bitboards[0] &= ~bit;
+            bitboards[1] &= ~bit;
+            if (value != 0) {
+                bitboards[value - 1] |= bit;
+            }
+        } else {
+            int index = flatIndex(row, col);
+            cells[index] = static_cast<uint8_t>(value);
+            if (previous == 0 && value != 0) {
+                occupyFrontier(index);
+            } else if (previous != 0 && value == 0) {
+                vacateFrontier(index);
+            }
+        }
+        if (value != 0) {
+            zobristHash ^= zobristKey(square, value);
+        }
+    }
+
+    // an empty board, every square of the padded layout starts as border
+    void clearBoard() {
+        bitboards[0] = 0;
+        bitboards[1] = 0;
+        cells.fill(BORDER_SQUARE);
+        occupiedNeighbours.fill(0);
+        frontier.fill(0);
+        if (!USES_BITBOARD) {
+            for (int row = 0; row < N; ++row) {
+                for (int col = 0; col < N; ++col) {
+                    cells[flatIndex(row, col)] = 0;
+                }
+            }
+        }
+        zobristHash = 0;
+    }
+
+public:
+    // initializes the starting position
+    FixedBoard() {
+        clearBoard();
+        int center = N / 2;
+        setSquare(center - 1, center - 1, 1);
+        setSquare(center - 1, center, 2);
+        setSquare(center, center - 1, 2);
+        setSquare(center, center, 1);
+    }
+
+    // copies a position from a Board of the same size
+    //
+    // parameters:
+    // const Board& board - the board to copy
+    //
+    // throws:
+    // std::invalid_argument if the sizes don't match
+    explicit FixedBoard(const Board& board) {
+        if (board.getMaxBoardSize() != N) {
+            throw std::invalid_argument("Board size doesn't match the fixed board size.");
+        }
+        clearBoard();
+        for (int row = 0; row < N; ++row) {
+            for (int col = 0; col < N; ++col) {
+                int value = board.getBoardPlaceValue({row, col});
+                if (value != 0) {
+                    setSquare(row, col, value);
+                }
+            }
+        }
+    }
+
+    // retrieves the board size
+    //
+    // returns:
+    // int - N
+    static constexpr int getMaxBoardSize() {
+        return N;
+    }
+
+    // retrieves the incrementally updated zobrist key, equal to Board::getHash for the same position
+    //
+    // returns:
+    // uint64_t - the key
+    uint64_t getHash() const {
+        return zobristHash;
+    }
+
+    // computes the zobrist key from scratch
+    //
+    // returns:
+    // uint64_t - XOR of the zobrist keys of every piece on the board
+    uint64_t hashBoard() const {
+        uint64_t boardHash = 0;
+        for (int row = 0; row < N; ++row) {
+            for (int col = 0; col < N; ++col) {
+                int value = getBoardPlaceValue({row, col});
+                if (value != 0) {
+                    boardHash ^= zobristKey(row * N + col, value);
+                }
+            }
+        }
+        return boardHash;
+    }
+
+    // retrieves the value at a position
+    //
+    // parameters:
+    // const std::pair<int, int>& position - the position on the board
+    //
+    // returns:
+    // int - 0 for empty, 1 for 'X', 2 for 'O'
+    //
+    // throws:
+    // std::out_of_range if the position is not on the board
+    int getBoardPlaceValue(const std::pair<int, int>& position) const {
+        if (position.first < 0 || position.first >= N || position.second < 0 || position.second >= N) {
+            throw std::out_of_range("position is not on the board.");
+        }
+        if (USES_BITBOARD) {
+            uint64_t bit = uint64_t(1) << (position.first * BITBOARD_STRIDE + position.second);
+            return (bitboards[0] & bit) ? 1 : (bitboards[1] & bit) ? 2 : 0;
+        }
+        return cells[flatIndex(position.first, position.second)];
+    }
+
+    // generates all valid moves for a player in row-major order,
+    // the same moves Board::getValidMoves returns for the same position
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // MoveList - the valid moves
+    MoveList getValidMoves(int player) const {
+        MoveList validMoves;
+
+        if (USES_BITBOARD) {
+            uint64_t legal = bitboardLegalMoves(player);
+            while (legal) {
+                int bitIndex = __builtin_ctzll(legal);
+                legal &= legal - 1;
+                Move& move = validMoves.add(bitIndex / BITBOARD_STRIDE, bitIndex % BITBOARD_STRIDE);
+                bitboardFlips(uint64_t(1) << bitIndex, player, move);
+            }
+            return validMoves;
+        }
+
+        // walk the frontier in row-major order
+        for (int word = 0; word < FRONTIER_WORDS; ++word) {
+            uint64_t bits = frontier[word];
+            while (bits) {
+                int index = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                Move candidate;
+                flatFlips(index, player, candidate);
+                if (candidate.flipCount > 0) {
+                    candidate.row = static_cast<int16_t>(index / FLAT_STRIDE - 1);
+                    candidate.col = static_cast<int16_t>(index % FLAT_STRIDE - 1);
+                    candidate.flipMask = 0;
+                    validMoves.add(candidate);
+                }
+            }
+        }
+        return validMoves;
+    }
+
+    // places a piece and flips the pieces recorded in the move
+    //
+    // parameters:
+    // const Move& move - the move to play, as generated by getValidMoves
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // throws:
+    // std::runtime_error if the square is already occupied
+    void placePiece(const Move& move, int player) {
+        if (USES_BITBOARD) {
+            uint64_t bit = uint64_t(1) << (move.row * BITBOARD_STRIDE + move.col);
+            if ((bitboards[0] | bitboards[1]) & bit) {
+                throw std::runtime_error("square is already occupied.");
+            }
+            bitboards[player - 1] |= bit;
+        } else {
+            int index = flatIndex(move.row, move.col);
+            if (cells[index] != 0) {
+                throw std::runtime_error("square is already occupied.");
+            }
+            cells[index] = static_cast<uint8_t>(player);
+            occupyFrontier(index);
+        }
+        zobristHash ^= zobristKey(move.row * N + move.col, player);
+        toggleFlips(move);
+    }
+
+    // takes back a move made with placePiece
+    //
+    // parameters:
+    // const Move& move - the move that was played
+    // int player - the player who played it (1 for 'X', 2 for 'O')
+    //
+    // throws:
+    // std::runtime_error if the square doesn't hold the player's piece
+    void undoMove(const Move& move, int player) {
+        if (USES_BITBOARD) {
+            uint64_t bit = uint64_t(1) << (move.row * BITBOARD_STRIDE + move.col);
+            if (!(bitboards[player - 1] & bit)) {
+                throw std::runtime_error("cannot undo a move that wasn't played.");
+            }
+            toggleFlips(move);
+            bitboards[player - 1] &= ~bit;
+        } else {
+            int index = flatIndex(move.row, move.col);
+            if (cells[index] != player) {
+                throw std::runtime_error("cannot undo a move that wasn't played.");
+            }
+            toggleFlips(move);
+            cells[index] = 0;
+            vacateFrontier(index);
+        }
+        zobristHash ^= zobristKey(move.row * N + move.col, player);
+    }
+
+    // counts the valid moves of a player, on a bitboard without working out their flips
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // int - the number of valid moves
+    int countValidMoves(int player) const {
+        if (USES_BITBOARD) {
+            return __builtin_popcountll(bitboardLegalMoves(player));
+        }
+        int count = 0;
+        for (int word = 0; word < FRONTIER_WORDS; ++word) {
+            uint64_t bits = frontier[word];
+            while (bits) {
+                int index = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                count += flatFlanks(index, player);
+            }
+        }
+        return count;
+    }
+
+    // counts the pieces a player has on the board
+    //
+    // parameters:
+    // int player - the player number (1 for 'X', 2 for 'O')
+    //
+    // returns:
+    // int - the number of pieces
+    int countPieces(int player) const {
+        if (USES_BITBOARD) {
+            return __builtin_popcountll(bitboards[player - 1]);
+        }
+        int count = 0;
+        for (uint8_t cell : cells) {
+            count += (cell == player);
+        }
+        return count;
+    }
+
+    // calls visit(row, col, player) for every piece on the board
+    //
+    // parameters:
+    // Visitor visit - called once per piece
+    //
+    // returns:
+    // void - does not return a value
+    template <typename Visitor>
+    void forEachPiece(Visitor visit) const {
+        if (USES_BITBOARD) {
+            for (int player = 1; player <= 2; ++player) {
+                uint64_t bits = bitboards[player - 1];
+                while (bits) {
+                    int bitIndex = __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    visit(bitIndex / BITBOARD_STRIDE, bitIndex % BITBOARD_STRIDE, player);
+                }
+            }
+            return;
+        }
+        for (int row = 0; row < N; ++row) {
+            for (int col = 0; col < N; ++col) {
+                int value = cells[flatIndex(row, col)];
+                if (value != 0) {
+                    visit(row, col, value);
+                }
+            }
+        }
+    }
+};
+
+
+// calls the visitor with a FixedBoard copy of the board when its size has a
+// specialization (6, 8, 10 or 12)
+//
+// parameters:
+// const Board& board - the board to copy
+// Visitor&& visitor - a generic lambda taking the FixedBoard by reference
+//
+// returns:
+// bool - true if the visitor was called, false for other sizes
+
+template <typename Visitor>
+inline bool withFixedBoard(const Board& board, Visitor&& visitor) {
+    switch (board.getMaxBoardSize()) {
+        case 6: {
+            FixedBoard<6> fixed(board);
+            visitor(fixed);
+            return true;
+        }
+        case 8: {
+            FixedBoard<8> fixed(board);
+            visitor(fixed);
+            return true;
+        }
+        case 10: {
+            FixedBoard<10> fixed(board);
+            visitor(fixed);
+            return true;
+        }
+        case 12: {
+            FixedBoard<12> fixed(board);
+            visitor(fixed);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+#endif /* FIXEDBOARD_H */
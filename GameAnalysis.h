@@ -0,0 +1,289 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Game Record Analysis
+ *
+ * Replays a file of game records (GameRecord.h) on several threads and
+ * gathers statistics over the games: the outcomes by board size, how
+ * many moves each player had to choose from, and how the game went after
+ * each first move.
+ *
+ * Records don't have a fixed length, so the file is walked once reading
+ * only the record prefixes and cut into chunks of GAME_ANALYSIS_CHUNK
+ * records. The threads take chunks until they run out, each reading its
+ * records straight from the one mapping and replaying them through
+ * Board::placePiece into its own GameAnalysis, and the threads' counters
+ * are merged once they are done. Nothing is shared while the threads run
+ * but the chunk counter.
+ *
+ */
+
+#ifndef GAMEANALYSIS_H
+#define GAMEANALYSIS_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+
+// include board implementation
+#include "Board.h"
+// include game record implementation
+#include "GameRecord.h"
+
+
+// records handed to a thread at a time
+const size_t GAME_ANALYSIS_CHUNK = 4096;
+
+// how a set of games ended
+struct GameOutcomes {
+    uint64_t games = 0;
+    uint64_t xWins = 0;
+    uint64_t oWins = 0;
+    uint64_t draws = 0;
+
+    // counts a game
+    //
+    // parameters:
+    // int winner - 1 for X, 2 for O, 0 for a draw
+    //
+    // returns:
+    // void - does not return a value
+    void add(int winner) {
+        games++;
+        if (winner == 1) {
+            xWins++;
+        } else if (winner == 2) {
+            oWins++;
+        } else {
+            draws++;
+        }
+    }
+
+    void merge(const GameOutcomes& other) {
+        games += other.games;
+        xWins += other.xWins;
+        oWins += other.oWins;
+        draws += other.draws;
+    }
+};
+
+// the games of one board size
+struct BoardSizeAnalysis {
+    GameOutcomes outcomes;
+    // moves played, passes aren't counted
+    uint64_t moves = 0;
+    uint64_t passes = 0;
+    // valid moves summed over every position a move was played from
+    uint64_t validMoves = 0;
+    // outcomes by the square of the first move, row * size + col
+    std::vector<GameOutcomes> firstMoves;
+
+    // retrieves the average number of valid moves a player had to choose from
+    //
+    // returns:
+    // double - the branching factor, 0 without moves
+    double branchingFactor() const {
+        return moves > 0 ? static_cast<double>(validMoves) / moves : 0.0;
+    }
+
+    void merge(const BoardSizeAnalysis& other) {
+        outcomes.merge(other.outcomes);
+        moves += other.moves;
+        passes += other.passes;
+        validMoves += other.validMoves;
+        if (firstMoves.size() < other.firstMoves.size()) {
+            firstMoves.resize(other.firstMoves.size());
+        }
+        for (size_t i = 0; i < other.firstMoves.size(); ++i) {
+            firstMoves[i].merge(other.firstMoves[i]);
+        }
+    }
+};
+
+// the statistics of a set of games
+struct GameAnalysis {
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    // by board size, a size without games has no games counted
+    std::vector<BoardSizeAnalysis> bySize;
+    // bytes of records read
+    size_t bytes = 0;
+    int threads = 0;
+    // wall clock time of the whole run
+    double seconds = 0.0;
+
+    // retrieves the counters of a board size, adding them if needed
+    //
+    // parameters:
+    // int boardSize - the size of the board
+    //
+    // returns:
+    // BoardSizeAnalysis& - the counters
+    BoardSizeAnalysis& size(int boardSize) {
+        if (bySize.size() <= static_cast<size_t>(boardSize)) {
+            bySize.resize(boardSize + 1);
+        }
+        BoardSizeAnalysis& sizeAnalysis = bySize[boardSize];
+        if (sizeAnalysis.firstMoves.empty()) {
+            sizeAnalysis.firstMoves.resize(boardSize * boardSize);
+        }
+        return sizeAnalysis;
+    }
+
+    void merge(const GameAnalysis& other) {
+        games += other.games;
+        moves += other.moves;
+        if (bySize.size() < other.bySize.size()) {
+            bySize.resize(other.bySize.size());
+        }
+        for (size_t i = 0; i < other.bySize.size(); ++i) {
+            bySize[i].merge(other.bySize[i]);
+        }
+    }
+};
+
+
+// replays one record and adds it to the statistics
+//
+// parameters:
+// const GameRecordView& record - the game
+// GameAnalysis& analysis - the counters the game is added to
+//
+// returns:
+// void - does not return a value
+//
+// throws:
+// std::runtime_error if the record holds a move that isn't valid
+
+inline void analyzeGameRecord(const GameRecordView& record, GameAnalysis& analysis) {
+    BoardSizeAnalysis& sizeAnalysis = analysis.size(record.boardSize);
+    uint64_t moves = 0;
+    uint64_t validMoves = 0;
+    int firstMove = -1;
+
+    Board board = replayGameRecord(record, [&](const Board& position, int player, const Move& move) {
+        if (firstMove < 0) {
+            firstMove = move.row * record.boardSize + move.col;
+        }
+        validMoves += position.countValidMoves(player);
+        ++moves;
+    });
+
+    int xCount = board.countPieces(1);
+    int oCount = board.countPieces(2);
+    int winner = (xCount > oCount) ? 1 : (oCount > xCount) ? 2 : 0;
+
+    analysis.games++;
+    analysis.moves += moves;
+    sizeAnalysis.outcomes.add(winner);
+    sizeAnalysis.moves += moves;
+    sizeAnalysis.passes += record.entryCount - moves;
+    sizeAnalysis.validMoves += validMoves;
+    if (firstMove >= 0) {
+        sizeAnalysis.firstMoves[firstMove].add(winner);
+    }
+}
+
+
+// replays every game of a record file across threads
+//
+// parameters:
+// const std::string& path - the record file
+// int threads - the threads replaying, at least 1
+//
+// returns:
+// GameAnalysis - the statistics over every complete record
+//
+// throws:
+// std::invalid_argument if threads is less than 1
+// std::runtime_error if the file can't be read or holds a game that isn't valid
+
+inline GameAnalysis analyzeGameRecords(const std::string& path, int threads) {
+    if (threads < 1) {
+        throw std::invalid_argument("The analysis needs at least 1 thread.");
+    }
+    auto start = std::chrono::steady_clock::now();
+    GameRecordReader reader(path);
+
+    // the start of every chunk, then the end of the last complete record
+    std::vector<size_t> chunks;
+    {
+        GameRecordView record;
+        size_t records = 0;
+        chunks.push_back(reader.offset());
+        while (reader.next(record)) {
+            if (++records % GAME_ANALYSIS_CHUNK == 0) {
+                chunks.push_back(reader.offset());
+            }
+        }
+        if (records % GAME_ANALYSIS_CHUNK != 0) {
+            chunks.push_back(reader.offset());
+        }
+    }
+    size_t chunkCount = chunks.size() - 1;
+    int threadCount = static_cast<int>(std::max<size_t>(std::min<size_t>(threads, chunkCount), 1));
+
+    std::vector<GameAnalysis> threadAnalyses(threadCount);
+    std::atomic<size_t> nextChunk(0);
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    std::string error;
+    std::vector<std::thread> workers;
+
+    for (int worker = 0; worker < threadCount; ++worker) {
+        workers.emplace_back([&, worker]() {
+            GameAnalysis& analysis = threadAnalyses[worker];
+            try {
+                size_t chunk;
+                while (!failed.load(std::memory_order_relaxed) &&
+                       (chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount) {
+                    size_t offset = chunks[chunk];
+                    GameRecordView record;
+                    while (offset < chunks[chunk + 1]) {
+                        size_t recordOffset = offset;
+                        reader.read(offset, record);
+                        try {
+                            analyzeGameRecord(record, analysis);
+                        } catch (const std::runtime_error& e) {
+                            throw std::runtime_error(std::string(e.what()) + " (" + path + ", byte " +
+                                                     std::to_string(recordOffset) + ")");
+                        }
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!failed.exchange(true)) {
+                    error = e.what();
+                }
+            }
+        });
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (failed.load()) {
+        throw std::runtime_error(error);
+    }
+
+    // add up the threads
+    GameAnalysis total;
+    for (const auto& analysis : threadAnalyses) {
+        total.merge(analysis);
+    }
+    total.bytes = chunks.back();
+    total.threads = threadCount;
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+#endif /* GAMEANALYSIS_H */
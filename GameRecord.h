@@ -0,0 +1,457 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Binary Game Records
+ *
+ * Stores finished games compactly so millions of self-play games can be
+ * kept for analysis and training. A file is a header followed by one
+ * record per game
+ *
+ *   GameRecordHeader (16 bytes)
+ *   record: board size (1 byte), entry count (2 bytes, little endian),
+ *           entries ...
+ *
+ * An entry is a square index (row * size + col), 1 byte on boards up to
+ * 16x16 and 2 bytes (little endian) on larger ones, so an 8x8 game of 60
+ * moves is 63 bytes. A pass is stored as the index of the upper left
+ * centre square, which holds a starting piece and can never be played.
+ * The moves alternate X, O, X, ... with the passes in between, so the
+ * player of each move isn't stored, and the final passes of a finished
+ * game are left out.
+ *
+ * GameRecordWriter collects records in a buffer and appends it to the
+ * file when it fills up, a crash can at most leave a partial last record,
+ * which the reader ignores and the next writer cuts off. Writes lock the
+ * writer, so the self-play threads can share one.
+ *
+ * GameRecordReader maps the file read-only and walks it one record at a
+ * time, a record is a view into the mapping and nothing is copied, only
+ * the pages being read are paged in, and read() lets several threads
+ * walk parts of one mapping. replayGameRecord plays a record on a
+ * Board, building each move from the one square played (Board::getMove)
+ * rather than generating every valid move.
+ *
+ */
+
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stack>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <stdexcept>
+#include <algorithm>
+
+// include board implementation
+#include "Board.h"
+// include memory mapped file implementation
+#include "MappedFile.h"
+
+
+// first bytes of a game record file
+const char GAME_RECORD_MAGIC[8] = {'O', 'T', 'H', 'G', 'A', 'M', 'E', 'S'};
+const uint32_t GAME_RECORD_VERSION = 1;
+// largest board whose entries are 1 byte
+const int GAME_RECORD_BYTE_MAX_SIZE = 16;
+// largest board a record can hold, the size is 1 byte
+const int GAME_RECORD_MAX_SIZE = 255;
+// bytes before a record's entries
+const size_t GAME_RECORD_PREFIX = 3;
+// bytes the writer collects before appending them to the file
+const size_t GAME_RECORD_BUFFER = 1 << 20;
+
+// the start of a game record file
+struct GameRecordHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(GameRecordHeader) == 16, "the game record header is 16 bytes");
+
+
+// the entry that stands for a pass
+//
+// parameters:
+// int size - the board size
+//
+// returns:
+// int - the square index of the upper left centre square
+inline int gameRecordPassIndex(int size) {
+    return (size / 2 - 1) * size + (size / 2 - 1);
+}
+
+// the bytes of one entry
+//
+// parameters:
+// int size - the board size
+//
+// returns:
+// size_t - 1 on boards up to 16x16, 2 on larger ones
+inline size_t gameRecordEntryBytes(int size) {
+    return (size <= GAME_RECORD_BYTE_MAX_SIZE) ? 1 : 2;
+}
+
+
+// one game of a file, pointing into the mapping
+struct GameRecordView {
+    int boardSize = 0;
+    // moves and passes
+    size_t entryCount = 0;
+    const uint8_t* entries = nullptr;
+
+    // retrieves an entry's square index
+    //
+    // parameters:
+    // size_t i - the entry, 0 for the first
+    //
+    // returns:
+    // int - row * size + col, gameRecordPassIndex(size) for a pass
+    int entry(size_t i) const {
+        if (boardSize <= GAME_RECORD_BYTE_MAX_SIZE) {
+            return entries[i];
+        }
+        return entries[2 * i] | (entries[2 * i + 1] << 8);
+    }
+};
+
+
+class GameRecordWriter {
+private:
+    std::string path;
+    std::mutex mutex;
+    std::ofstream out;
+    std::vector<uint8_t> buffer;
+    uint64_t gamesWritten = 0;
+
+    // appends the buffer to the file
+    void writeBuffer() {
+        if (buffer.empty()) {
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        buffer.clear();
+    }
+
+public:
+    // opens a record file for appending, it's created if it doesn't exist
+    //
+    // parameters:
+    // const std::string& recordPath - the file
+    //
+    // throws:
+    // std::runtime_error if the file isn't a game record file or can't be written
+    explicit GameRecordWriter(const std::string& recordPath);
+
+    // writes out what's still buffered, errors are lost here, call flush to see them
+    ~GameRecordWriter() {
+        try {
+            flush();
+        } catch (const std::exception&) {
+        }
+    }
+
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    // records a game, a move by the same player as the one before means the other player passed
+    //
+    // parameters:
+    // int boardSize - the board size
+    // const std::vector<PlayerMove>& moves - the moves in the order they were played
+    //
+    // returns:
+    // void - does not return a value
+    //
+    // throws:
+    // std::invalid_argument if the board is too large or the game too long for a record
+    // std::runtime_error if the file can't be written
+    void write(int boardSize, const std::vector<PlayerMove>& moves) {
+        if (boardSize < 4 || boardSize > GAME_RECORD_MAX_SIZE) {
+            throw std::invalid_argument("Game records hold boards of 4 to 255.");
+        }
+        size_t entryBytes = gameRecordEntryBytes(boardSize);
+        int passIndex = gameRecordPassIndex(boardSize);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t start = buffer.size();
+        buffer.resize(start + GAME_RECORD_PREFIX);
+        size_t entries = 0;
+        auto add = [&](int index) {
+            buffer.push_back(static_cast<uint8_t>(index));
+            if (entryBytes == 2) {
+                buffer.push_back(static_cast<uint8_t>(index >> 8));
+            }
+            ++entries;
+        };
+
+        int expected = 1;
+        for (const PlayerMove& move : moves) {
+            if (move.thePlayer != expected) {
+                add(passIndex);
+            }
+            add(move.theLocation.first * boardSize + move.theLocation.second);
+            expected = (move.thePlayer == 1) ? 2 : 1;
+        }
+        if (entries > 0xFFFF) {
+            buffer.resize(start);
+            throw std::invalid_argument("A game record holds at most 65535 moves and passes.");
+        }
+        buffer[start] = static_cast<uint8_t>(boardSize);
+        buffer[start + 1] = static_cast<uint8_t>(entries);
+        buffer[start + 2] = static_cast<uint8_t>(entries >> 8);
+        ++gamesWritten;
+
+        if (buffer.size() >= GAME_RECORD_BUFFER) {
+            writeBuffer();
+        }
+    }
+
+    // records a game from its history, as kept by playGame
+    //
+    // parameters:
+    // int boardSize - the board size
+    // std::stack<PlayerMove> gameHistory - the moves, the last one on top
+    //
+    // returns:
+    // void - does not return a value
+    //
+    // throws:
+    // see write(int, const std::vector<PlayerMove>&)
+    void write(int boardSize, std::stack<PlayerMove> gameHistory) {
+        std::vector<PlayerMove> moves;
+        moves.reserve(gameHistory.size());
+        while (!gameHistory.empty()) {
+            moves.push_back(gameHistory.top());
+            gameHistory.pop();
+        }
+        std::reverse(moves.begin(), moves.end());
+        write(boardSize, moves);
+    }
+
+    // appends everything buffered to the file
+    //
+    // returns:
+    // void - does not return a value
+    //
+    // throws:
+    // std::runtime_error if the file can't be written
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        writeBuffer();
+    }
+
+    // retrieves the number of games written by this writer
+    //
+    // returns:
+    // uint64_t - the games, buffered ones included
+    uint64_t games() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return gamesWritten;
+    }
+};
+
+
+class GameRecordReader {
+private:
+    std::string path;
+    std::unique_ptr<MappedFile> file;
+    size_t position = sizeof(GameRecordHeader);
+
+public:
+    // maps a record file
+    //
+    // parameters:
+    // const std::string& recordPath - the file
+    //
+    // throws:
+    // std::runtime_error if the file can't be opened or isn't a game record file
+    explicit GameRecordReader(const std::string& recordPath) : path(recordPath), file(new MappedFile(recordPath)) {
+        GameRecordHeader header;
+        if (file->size() < sizeof(header)) {
+            throw std::runtime_error(path + " is not a game record file.");
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, GAME_RECORD_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(path + " is not a game record file.");
+        }
+        if (header.version != GAME_RECORD_VERSION) {
+            throw std::runtime_error(path + " was written by another version.");
+        }
+    }
+
+    GameRecordReader(const GameRecordReader&) = delete;
+    GameRecordReader& operator=(const GameRecordReader&) = delete;
+
+    // moves to the next record
+    //
+    // parameters:
+    // GameRecordView& record - set to the record, valid as long as the reader
+    //
+    // returns:
+    // bool - false at the end of the file or at a partial last record
+    //
+    // throws:
+    // std::runtime_error if a record's board size isn't valid
+    bool next(GameRecordView& record) {
+        return read(position, record);
+    }
+
+    // reads the record at an offset without moving the reader, several
+    // threads can read the same reader at once
+    //
+    // parameters:
+    // size_t& offset - the start of a record, moved to the start of the next one
+    // GameRecordView& record - set to the record, valid as long as the reader
+    //
+    // returns:
+    // bool - false at the end of the file or at a partial last record
+    //
+    // throws:
+    // std::runtime_error if a record's board size isn't valid
+    bool read(size_t& offset, GameRecordView& record) const {
+        const uint8_t* bytes = file->data();
+        size_t length = file->size();
+        if (offset + GAME_RECORD_PREFIX > length) {
+            return false;
+        }
+        int size = bytes[offset];
+        if (size < 4) {
+            throw std::runtime_error(path + " has a record with an invalid board size.");
+        }
+        size_t entries = bytes[offset + 1] | (bytes[offset + 2] << 8);
+        size_t end = offset + GAME_RECORD_PREFIX + entries * gameRecordEntryBytes(size);
+        if (end > length) {
+            return false;
+        }
+        record.boardSize = size;
+        record.entryCount = entries;
+        record.entries = bytes + offset + GAME_RECORD_PREFIX;
+        offset = end;
+        return true;
+    }
+
+    // retrieves how far the reader got
+    //
+    // returns:
+    // size_t - the offset of the next record, the end of the last complete one at the end
+    size_t offset() const {
+        return position;
+    }
+
+    // retrieves the mapped bytes
+    //
+    // returns:
+    // const MappedFile& - the mapped file
+    const MappedFile& mapped() const {
+        return *file;
+    }
+};
+
+
+inline GameRecordWriter::GameRecordWriter(const std::string& recordPath) : path(recordPath) {
+    buffer.reserve(GAME_RECORD_BUFFER + 4096);
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (!error && fileSize > 0) {
+        // cut off a partial record left by a crash, so the new ones line up
+        size_t end;
+        {
+            GameRecordReader reader(path);
+            GameRecordView record;
+            while (reader.next(record)) {
+            }
+            end = reader.offset();
+        }
+        if (end < fileSize) {
+            std::filesystem::resize_file(path, end, error);
+            if (error) {
+                throw std::runtime_error("Cannot remove the partial record at the end of " + path);
+            }
+        }
+    }
+
+    out.open(path, std::ios::binary | std::ios::app);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    // a new file starts with the header
+    out.seekp(0, std::ios::end);
+    if (out.tellp() == 0) {
+        GameRecordHeader header = {};
+        std::memcpy(header.magic, GAME_RECORD_MAGIC, sizeof(header.magic));
+        header.version = GAME_RECORD_VERSION;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+}
+
+
+// plays a recorded game on a new board
+//
+// parameters:
+// const GameRecordView& record - the game
+// Visitor visit - called as visit(const Board& board, int player, const Move& move) before each move is played
+//
+// returns:
+// Board - the board at the end of the game
+//
+// throws:
+// std::runtime_error if the record holds a move that isn't valid
+
+template <typename Visitor>
+inline Board replayGameRecord(const GameRecordView& record, Visitor visit) {
+    int size = record.boardSize;
+    int passIndex = gameRecordPassIndex(size);
+    Board board(size);
+    int player = 1;
+    for (size_t i = 0; i < record.entryCount; ++i) {
+        int index = record.entry(i);
+        if (index != passIndex) {
+            if (index >= size * size) {
+                throw std::runtime_error("A game record has a square off the board.");
+            }
+            Move move = board.getMove({index / size, index % size}, player);
+            if (move.flipCount == 0) {
+                throw std::runtime_error("A game record has a move that isn't valid.");
+            }
+            visit(static_cast<const Board&>(board), player, static_cast<const Move&>(move));
+            board.placePiece(move, player);
+        }
+        player = (player == 1) ? 2 : 1;
+    }
+    return board;
+}
+
+// plays a recorded game on a new board
+//
+// parameters:
+// const GameRecordView& record - the game
+//
+// returns:
+// Board - the board at the end of the game
+//
+// throws:
+// std::runtime_error if the record holds a move that isn't valid
+
+inline Board replayGameRecord(const GameRecordView& record) {
+    return replayGameRecord(record, [](const Board&, int, const Move&) {});
+}
+
+#endif /* GAMERECORD_H */
@@ -0,0 +1,797 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Game Server
+ *
+ * Hosts many games at once over TCP (--serve PORT). Each game is a
+ * session with its own Board and gameHistory, a connection can open as
+ * many sessions as it likes. One I/O thread runs an epoll loop over the
+ * listening socket and every connection, all sockets are non-blocking so
+ * a slow client never holds up another. The AI turns that come up while
+ * the loop handles a round of events are searched as one batch by
+ * getAIMoves, on a work stealing pool with one transposition table shared
+ * by every game, and a worker wakes the I/O thread through an eventfd
+ * each time a move is ready. A long search only ever ties up its worker.
+ *
+ * The protocol is text, one command per line, squares are 0 based
+ * (row col) and players are X and O
+ *
+ *   NEW size [x|o|none]   start a game, the AI plays the given side
+ *                         (default o, like the interactive game)
+ *                         -> NEW id, then the game's events
+ *   MOVE id row col       play a move for the side to move
+ *   BOARD id              -> BOARD id size player cells, the cells row
+ *                            by row as . X O
+ *   CLOSE id              -> CLOSED id
+ *
+ * Games report their events as they happen, AI moves arrive whenever the
+ * worker is done
+ *
+ *   MOVED id player row col   a move was played, by the client or the AI
+ *   PASS id player            the player has no valid moves
+ *   TURN id player            the client is to move
+ *   END id xCount oCount      neither player can move, the game is over
+ *   ERR id message            the command was refused, id is - if unknown
+ *
+ * Only the AI plays while it's thinking, a MOVE for that game is refused.
+ * Closing a connection closes its games, an AI move that comes back for a
+ * closed game is dropped. A client that closes its side of the connection
+ * still gets the replies to every line it sent, the server closes once
+ * they're sent and none of its games is waiting for the AI.
+ *
+ * The server stops reading a client that sends commands without reading
+ * the replies once SERVER_MAX_OUTPUT bytes wait to be sent to it, its
+ * remaining lines run as the socket takes the output, so neither buffer
+ * grows past a few kilobytes over its limit.
+ *
+ * The event loop uses epoll and eventfd, so the server only runs on
+ * Linux, elsewhere run() throws. The sessions and the protocol don't
+ * depend on the platform.
+ *
+ */
+
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <string>
+#include <vector>
+#include <stack>
+#include <sstream>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#endif
+
+// include board implementation
+#include "Board.h"
+// include search implementation
+#include "Search.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include batched search implementation
+#include "BatchSearch.h"
+
+
+// longest command line accepted, a client sending more is disconnected
+const size_t SERVER_MAX_LINE = 4096;
+
+// unsent output a connection can have before its commands stop being read
+const size_t SERVER_MAX_OUTPUT = 256 * 1024;
+
+// settings for the server
+struct ServerOptions {
+    // TCP port to listen on, 0 picks a free one
+    int port = 0;
+    // AI worker threads
+    int workers = 1;
+    // memory budget of the transposition table the workers share
+    size_t ttMegabytes = 64;
+    TTReplacement ttReplacement = TTReplacement::DEPTH_PREFERRED;
+    // search used for AI turns, run single threaded on a worker
+    SearchOptions search;
+    // games open at the same time across all connections
+    size_t maxSessions = 100000;
+    // polled by the event loop, the server returns once it's set, nullptr runs forever
+    const std::atomic<bool>* stop = nullptr;
+};
+
+// one game on the server
+struct GameSession {
+    // the connection that opened it
+    int connection = -1;
+    Board board;
+    std::stack<PlayerMove> gameHistory;
+    int currentPlayer = 1;
+    bool prevPlayerMoved = true;
+    // the side the AI plays, 0 if both sides are played by the client
+    int aiPlayer = 2;
+    // an AI move is being searched
+    bool thinking = false;
+    bool over = false;
+
+    explicit GameSession(int boardSize) : board(boardSize) {}
+};
+
+class GameServer {
+private:
+    // a client connection and its buffered I/O
+    struct Connection {
+        std::string input;
+        std::string output;
+        std::unordered_set<uint64_t> sessions;
+        // the epoll events the connection is registered for
+        uint32_t watched = 0;
+        // the client closed its side, nothing more will be read
+        bool inputClosed = false;
+    };
+
+    ServerOptions options;
+    std::unordered_map<int, Connection> connections;
+    std::unordered_map<uint64_t, GameSession> sessions;
+    uint64_t nextSessionId = 1;
+    // connections with output to send
+    std::unordered_set<int> pendingOutput;
+    // counters for the report when the server stops
+    uint64_t sessionsOpened = 0;
+    uint64_t movesPlayed = 0;
+
+    int epollFd = -1;
+    int wakeFd = -1;
+    TranspositionTable table;
+    // AI turns waiting for the end of the round to be searched together
+    std::vector<AIMoveRequest> batch;
+    // moves the workers have finished, guarded by resultMutex
+    std::mutex resultMutex;
+    std::vector<AIMoveResult> results;
+    // stopped first when the server goes away, the workers use everything above
+    std::unique_ptr<WorkStealingPool> pool;
+
+    static char playerName(int player) {
+        return (player == 1) ? 'X' : 'O';
+    }
+
+    // queues a line of output for a connection
+    //
+    // parameters:
+    // int connection - the connection
+    // const std::string& line - the line, without the newline
+    //
+    // returns:
+    // void - does not return a value
+    void reply(int connection, const std::string& line) {
+        auto found = connections.find(connection);
+        if (found == connections.end()) {
+            return;
+        }
+        found->second.output += line;
+        found->second.output += '\n';
+        pendingOutput.insert(connection);
+    }
+
+    // plays the game on until the client has to move, the AI is thinking or the game is over
+    //
+    // parameters:
+    // uint64_t id - the session
+    // GameSession& session - the session
+    //
+    // returns:
+    // void - does not return a value
+    void advance(uint64_t id, GameSession& session) {
+        std::string prefix = std::to_string(id) + " ";
+        while (true) {
+            int player = session.currentPlayer;
+            if (session.board.countValidMoves(player) == 0) {
+                // neither player has valid moves
+                if (!session.prevPlayerMoved) {
+                    session.over = true;
+                    reply(session.connection, "END " + prefix + std::to_string(session.board.countPieces(1)) + " " +
+                                              std::to_string(session.board.countPieces(2)));
+                    return;
+                }
+                reply(session.connection, "PASS " + prefix + playerName(player));
+                session.prevPlayerMoved = false;
+                session.currentPlayer = (player == 1) ? 2 : 1;
+                continue;
+            }
+            if (player == session.aiPlayer) {
+                session.thinking = true;
+                batch.push_back(AIMoveRequest{id, session.board, player});
+            } else {
+                reply(session.connection, "TURN " + prefix + playerName(player));
+            }
+            return;
+        }
+    }
+
+    // plays a move for the side to move
+    //
+    // parameters:
+    // uint64_t id - the session
+    // GameSession& session - the session
+    // std::pair<int, int> position - the square
+    //
+    // returns:
+    // bool - false if the move isn't valid
+    bool play(uint64_t id, GameSession& session, std::pair<int, int> position) {
+        int player = session.currentPlayer;
+        MoveList validMoves = session.board.getValidMoves(player);
+        const Move* move = validMoves.find(position);
+        if (!move) {
+            return false;
+        }
+        session.board.placePiece(*move, player);
+        session.gameHistory.push(PlayerMove(player, position));
+        session.prevPlayerMoved = true;
+        session.currentPlayer = (player == 1) ? 2 : 1;
+        ++movesPlayed;
+        reply(session.connection, "MOVED " + std::to_string(id) + " " + playerName(player) + " " +
+                                  std::to_string(position.first) + " " + std::to_string(position.second));
+        advance(id, session);
+        return true;
+    }
+
+    // closes a session
+    //
+    // parameters:
+    // uint64_t id - the session
+    //
+    // returns:
+    // void - does not return a value
+    void closeSession(uint64_t id) {
+        auto found = sessions.find(id);
+        if (found == sessions.end()) {
+            return;
+        }
+        auto owner = connections.find(found->second.connection);
+        if (owner != connections.end()) {
+            owner->second.sessions.erase(id);
+        }
+        sessions.erase(found);
+    }
+
+    // looks up a session for a command, replying with an error if it isn't this connection's
+    //
+    // parameters:
+    // int connection - the connection the command came from
+    // const std::string& idText - the id as sent
+    // uint64_t& id - set to the id
+    //
+    // returns:
+    // GameSession* - the session, nullptr after replying with an error
+    GameSession* findSession(int connection, const std::string& idText, uint64_t& id) {
+        try {
+            size_t used = 0;
+            id = std::stoull(idText, &used);
+            if (used == idText.size()) {
+                auto found = sessions.find(id);
+                if (found != sessions.end() && found->second.connection == connection) {
+                    return &found->second;
+                }
+            }
+        } catch (const std::exception&) {
+            // fall through to the error below
+        }
+        reply(connection, "ERR " + (idText.empty() ? std::string("-") : idText) + " unknown game");
+        return nullptr;
+    }
+
+    // hands the AI turns of this round to the workers
+    //
+    // returns:
+    // void - does not return a value
+    void searchBatch() {
+        if (batch.empty()) {
+            return;
+        }
+        getAIMoves(batch.data(), batch.size(), *pool, table, options.search, [this](const AIMoveResult& result) {
+            {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                results.push_back(result);
+            }
+            wake();
+        });
+        batch.clear();
+    }
+
+    // applies the AI moves the workers have finished
+    //
+    // returns:
+    // void - does not return a value
+    void applyResults() {
+        std::vector<AIMoveResult> finished;
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            finished.swap(results);
+        }
+        for (const AIMoveResult& result : finished) {
+            auto found = sessions.find(result.id);
+            // the game was closed while the AI was thinking
+            if (found == sessions.end()) {
+                continue;
+            }
+            GameSession& session = found->second;
+            session.thinking = false;
+            // a connection that is done sending may be waiting for this move to close
+            pendingOutput.insert(session.connection);
+            if (result.failed || !play(result.id, session, result.move)) {
+                session.over = true;
+                reply(session.connection, "ERR " + std::to_string(result.id) + " AI failed: " +
+                                          (result.failed ? result.message : std::string("invalid move")));
+            }
+        }
+    }
+
+public:
+    // sets up the server and starts the AI workers, nothing is listened on until run
+    //
+    // parameters:
+    // const ServerOptions& serverOptions - the port, workers and search
+    explicit GameServer(const ServerOptions& serverOptions)
+        : options(serverOptions),
+          table(serverOptions.ttMegabytes, serverOptions.ttReplacement),
+          pool(new WorkStealingPool(serverOptions.workers)) {
+#ifdef __linux__
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            throw std::runtime_error(std::string("Cannot create the wake up eventfd: ") + std::strerror(errno));
+        }
+#endif
+    }
+
+    ~GameServer() {
+        pool.reset();
+#ifdef __linux__
+        for (auto& connection : connections) {
+            ::close(connection.first);
+        }
+        if (epollFd >= 0) {
+            ::close(epollFd);
+        }
+        if (wakeFd >= 0) {
+            ::close(wakeFd);
+        }
+#endif
+    }
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // wakes the event loop, called by the workers
+    //
+    // returns:
+    // void - does not return a value
+    void wake() {
+#ifdef __linux__
+        uint64_t one = 1;
+        // the counter only has to be non-zero, a full counter is already a wake up
+        ssize_t written = ::write(wakeFd, &one, sizeof(one));
+        (void)written;
+#endif
+    }
+
+    // runs one command line from a connection
+    //
+    // parameters:
+    // int connection - the connection it came from
+    // const std::string& line - the command, without the newline
+    //
+    // returns:
+    // void - does not return a value
+    void handleLine(int connection, const std::string& line) {
+        std::istringstream in(line);
+        std::string command;
+        if (!(in >> command)) {
+            return;
+        }
+
+        if (command == "NEW") {
+            int size = 0;
+            std::string side = "o";
+            in >> size >> side;
+            if (size < 4 || size > 64 || size % 2 != 0) {
+                reply(connection, "ERR - board size must be even, 4 to 64");
+                return;
+            }
+            if (side != "x" && side != "o" && side != "none") {
+                reply(connection, "ERR - AI side must be x, o or none");
+                return;
+            }
+            if (sessions.size() >= options.maxSessions) {
+                reply(connection, "ERR - too many games");
+                return;
+            }
+            uint64_t id = nextSessionId++;
+            GameSession& session = sessions.emplace(id, GameSession(size)).first->second;
+            session.connection = connection;
+            session.aiPlayer = (side == "x") ? 1 : (side == "o") ? 2 : 0;
+            connections[connection].sessions.insert(id);
+            ++sessionsOpened;
+            reply(connection, "NEW " + std::to_string(id));
+            advance(id, session);
+        } else if (command == "MOVE") {
+            std::string idText;
+            int row = -1;
+            int col = -1;
+            in >> idText >> row >> col;
+            uint64_t id;
+            GameSession* session = findSession(connection, idText, id);
+            if (!session) {
+                return;
+            }
+            if (session->over) {
+                reply(connection, "ERR " + idText + " game is over");
+            } else if (session->thinking) {
+                reply(connection, "ERR " + idText + " AI is thinking");
+            } else if (!play(id, *session, {row, col})) {
+                reply(connection, "ERR " + idText + " invalid move");
+            }
+        } else if (command == "BOARD") {
+            std::string idText;
+            in >> idText;
+            uint64_t id;
+            GameSession* session = findSession(connection, idText, id);
+            if (!session) {
+                return;
+            }
+            int size = session->board.getMaxBoardSize();
+            std::string cells;
+            cells.reserve(size * size);
+            for (int row = 0; row < size; ++row) {
+                for (int col = 0; col < size; ++col) {
+                    int value = session->board.getBoardPlaceValue({row, col});
+                    cells += (value == 0) ? '.' : playerName(value);
+                }
+            }
+            reply(connection, "BOARD " + idText + " " + std::to_string(size) + " " +
+                              playerName(session->currentPlayer) + " " + cells);
+        } else if (command == "CLOSE") {
+            std::string idText;
+            in >> idText;
+            uint64_t id;
+            if (findSession(connection, idText, id)) {
+                closeSession(id);
+                reply(connection, "CLOSED " + idText);
+            }
+        } else {
+            reply(connection, "ERR - unknown command " + command);
+        }
+    }
+
+#ifdef __linux__
+private:
+    // registers the events a connection waits for, input while it's read
+    // from and output while some is left to send
+    //
+    // parameters:
+    // int fd - the connection
+    // Connection& connection - its buffers
+    //
+    // returns:
+    // void - does not return a value
+    void watch(int fd, Connection& connection) {
+        bool reading = !connection.inputClosed && connection.output.size() < SERVER_MAX_OUTPUT;
+        uint32_t events = (reading ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                          (connection.output.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+        if (events != connection.watched) {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+            connection.watched = events;
+        }
+    }
+
+    // runs the complete lines a connection has sent, stopping while
+    // SERVER_MAX_OUTPUT bytes of output wait to be sent
+    //
+    // parameters:
+    // int fd - the connection
+    //
+    // returns:
+    // bool - false if the line left over was too long and the connection was closed
+    bool runLines(int fd) {
+        while (true) {
+            auto found = connections.find(fd);
+            if (found == connections.end()) {
+                return false;
+            }
+            Connection& connection = found->second;
+            size_t end = connection.input.find('\n');
+            if (end == std::string::npos) {
+                if (connection.input.size() > SERVER_MAX_LINE) {
+                    closeConnection(fd);
+                    return false;
+                }
+                return true;
+            }
+            if (connection.output.size() >= SERVER_MAX_OUTPUT) {
+                return true;
+            }
+            std::string line = connection.input.substr(0, end);
+            connection.input.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            handleLine(fd, line);
+        }
+    }
+
+    // closes a connection whose client closed its side once nothing is left
+    // to send and none of its games is waiting for the AI
+    //
+    // parameters:
+    // int fd - the connection
+    //
+    // returns:
+    // bool - true if the connection was closed
+    bool closeIfFinished(int fd) {
+        auto found = connections.find(fd);
+        if (found == connections.end()) {
+            return true;
+        }
+        const Connection& connection = found->second;
+        if (!connection.inputClosed || !connection.output.empty()) {
+            return false;
+        }
+        for (uint64_t id : connection.sessions) {
+            auto session = sessions.find(id);
+            if (session != sessions.end() && session->second.thinking) {
+                return false;
+            }
+        }
+        closeConnection(fd);
+        return true;
+    }
+
+    // sends what the socket takes of a connection's output, running the lines
+    // that waited for room in it, and watches for writability if some is left
+    //
+    // parameters:
+    // int fd - the connection
+    //
+    // returns:
+    // bool - false if the connection failed or finished and was closed
+    bool flush(int fd) {
+        while (true) {
+            auto found = connections.find(fd);
+            if (found == connections.end()) {
+                return false;
+            }
+            Connection& connection = found->second;
+            size_t sent = 0;
+            while (sent < connection.output.size()) {
+                ssize_t count = ::send(fd, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL);
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        break;
+                    }
+                    closeConnection(fd);
+                    return false;
+                }
+                sent += static_cast<size_t>(count);
+            }
+            connection.output.erase(0, sent);
+
+            // lines held back while the output was full
+            if (connection.output.size() >= SERVER_MAX_OUTPUT || connection.input.find('\n') == std::string::npos) {
+                watch(fd, connection);
+                return !closeIfFinished(fd);
+            }
+            if (!runLines(fd)) {
+                return false;
+            }
+        }
+    }
+
+    // reads what a connection has sent and runs its complete lines, until
+    // the socket is empty or the output is full
+    //
+    // parameters:
+    // int fd - the connection
+    //
+    // returns:
+    // void - does not return a value
+    void readConnection(int fd) {
+        char buffer[4096];
+        while (true) {
+            auto found = connections.find(fd);
+            if (found == connections.end()) {
+                return;
+            }
+            Connection& connection = found->second;
+            if (connection.inputClosed || connection.output.size() >= SERVER_MAX_OUTPUT) {
+                break;
+            }
+            ssize_t count = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (count < 0) {
+                closeConnection(fd);
+                return;
+            }
+            if (count == 0) {
+                // the lines already read still get their replies
+                connection.inputClosed = true;
+                break;
+            }
+            connection.input.append(buffer, static_cast<size_t>(count));
+            if (!runLines(fd)) {
+                return;
+            }
+        }
+        auto found = connections.find(fd);
+        if (found != connections.end()) {
+            watch(fd, found->second);
+            pendingOutput.insert(fd);
+        }
+    }
+
+    // closes a connection and its games
+    //
+    // parameters:
+    // int fd - the connection
+    //
+    // returns:
+    // void - does not return a value
+    void closeConnection(int fd) {
+        auto found = connections.find(fd);
+        if (found == connections.end()) {
+            return;
+        }
+        for (uint64_t id : found->second.sessions) {
+            sessions.erase(id);
+        }
+        connections.erase(found);
+        pendingOutput.erase(fd);
+        ::close(fd);
+    }
+
+    // accepts every waiting connection
+    //
+    // parameters:
+    // int listenFd - the listening socket
+    //
+    // returns:
+    // void - does not return a value
+    void acceptConnections(int listenFd) {
+        while (true) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                // EAGAIN when there are no more, anything else is the client's problem
+                return;
+            }
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+            connections[fd].watched = EPOLLIN;
+        }
+    }
+
+public:
+#endif
+
+    // listens on the port and serves games until options.stop is set
+    //
+    // parameters:
+    // std::ostream& log - where the port and the final counts are written
+    //
+    // returns:
+    // void - does not return a value
+    //
+    // throws:
+    // std::runtime_error if the socket can't be set up, or on a system without epoll
+    void run(std::ostream& log) {
+#ifdef __linux__
+        int listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            throw std::runtime_error(std::string("Cannot create the socket: ") + std::strerror(errno));
+        }
+        int one = 1;
+        ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listenFd, SOMAXCONN) != 0) {
+            std::string error = std::strerror(errno);
+            ::close(listenFd);
+            throw std::runtime_error("Cannot listen on port " + std::to_string(options.port) + ": " + error);
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+        event.data.fd = wakeFd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+        log << "Serving on port " << ntohs(address.sin_port) << ", " << std::max(options.workers, 1)
+            << " AI workers" << std::endl;
+
+        std::vector<epoll_event> events(256);
+        while (!(options.stop && options.stop->load())) {
+            // with a stop flag wake up now and then to look at it
+            int ready = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), options.stop ? 200 : -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptConnections(listenFd);
+                } else if (fd == wakeFd) {
+                    uint64_t count;
+                    ssize_t got = ::read(wakeFd, &count, sizeof(count));
+                    (void)got;
+                    applyResults();
+                } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(fd);
+                } else {
+                    if (events[i].events & EPOLLIN) {
+                        readConnection(fd);
+                    }
+                    if ((events[i].events & EPOLLOUT) && connections.count(fd)) {
+                        pendingOutput.insert(fd);
+                    }
+                }
+            }
+
+            // send everything the commands and AI moves produced, the lines that
+            // run once there's room can queue more AI turns so search after
+            std::vector<int> flushing(pendingOutput.begin(), pendingOutput.end());
+            pendingOutput.clear();
+            for (int fd : flushing) {
+                flush(fd);
+            }
+
+            searchBatch();
+        }
+
+        ::close(listenFd);
+        log << "Server stopped: " << sessionsOpened << " games opened, " << movesPlayed << " moves played" << std::endl;
+#else
+        (void)log;
+        throw std::runtime_error("The game server needs Linux (epoll).");
+#endif
+    }
+};
+
+#endif /* GAMESERVER_H */
@@ -0,0 +1,125 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Read-Only Memory Mapped File
+ *
+ * Maps a whole file read-only into memory. The pages come straight from
+ * the page cache, so nothing is parsed or copied on open and every
+ * process that maps the same file shares one copy of it.
+ *
+ * Uses mmap on POSIX systems and CreateFileMapping/MapViewOfFile on
+ * Windows (the MinGW build).
+ *
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+class MappedFile {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+public:
+    // maps a file read-only
+    //
+    // parameters:
+    // const std::string& path - the file to map
+    //
+    // throws:
+    // std::runtime_error if the file can't be opened or mapped
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("Cannot read the size of " + path);
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length > 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                // the view keeps the mapping alive
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(file, &info) != 0) {
+            ::close(file);
+            throw std::runtime_error("Cannot read the size of " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0);
+            bytes = (mapped == MAP_FAILED) ? nullptr : static_cast<const uint8_t*>(mapped);
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(file);
+#endif
+        if (length > 0 && !bytes) {
+            throw std::runtime_error("Cannot map " + path);
+        }
+    }
+
+    ~MappedFile() {
+        if (!bytes) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        ::munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+    }
+
+    // the mapping belongs to one object
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // retrieves the mapped bytes
+    //
+    // returns:
+    // const uint8_t* - the start of the file, nullptr if it's empty
+    const uint8_t* data() const {
+        return bytes;
+    }
+
+    // retrieves the size of the file
+    //
+    // returns:
+    // size_t - the size in bytes
+    size_t size() const {
+        return length;
+    }
+};
+
+#endif /* MAPPEDFILE_H */
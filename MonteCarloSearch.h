@@ -0,0 +1,404 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Monte Carlo Tree Search
+ *
+ * An alternative to the alpha-beta search for boards where its branching
+ * factor makes any useful depth too slow. Each iteration
+ *
+ * - walks down the tree from the root, at each node taking the child with
+ *   the best UCT score (its win rate plus an exploration bonus that grows
+ *   the less it has been tried), an untried child first
+ * - expands the leaf it reaches once it has been visited, adding a child
+ *   for each valid move (one pass child if only the opponent can move)
+ * - plays the game out from there with random moves
+ * - adds the result to every node on the way back up, a win for the
+ *   player who made the node's move counts 1 and a draw 1/2
+ *
+ * The moves are made on one board and taken back with undoMove, the
+ * playouts use the allocation-free getValidMoves and a move stack
+ * allocated once, so an iteration allocates nothing. The nodes live in a
+ * pool allocated once per tree, a node refers to its parent and children
+ * by index and keeps the Move that leads to it, so walking down the tree
+ * never generates moves. A full pool stops the tree from growing, the
+ * iterations still run their playouts from the leaves.
+ *
+ * With more than one thread every thread grows its own tree on its own
+ * copy of the board (root parallelism) and the root children's visits
+ * are added up once the threads are done, the most visited move wins.
+ * Nothing is shared between the threads while they run but the playout
+ * counter and the clock.
+ *
+ * The search is a template on the board type, getAIMove runs it on a
+ * FixedBoard for the common sizes like the other searches.
+ *
+ */
+
+#ifndef MONTECARLOSEARCH_H
+#define MONTECARLOSEARCH_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+// include random number implementation
+#include "Random.h"
+
+
+// playouts per move when there's no time limit
+const int MCTS_DEFAULT_PLAYOUTS = 2000;
+// nodes in each thread's pool by default, about 64 bytes each
+const uint32_t MCTS_DEFAULT_NODES = uint32_t(1) << 18;
+// weight of the exploration term of UCT
+const double MCTS_EXPLORATION = 1.4;
+// index of no node
+const uint32_t MCTS_NO_NODE = 0xFFFFFFFFu;
+
+// settings for a Monte Carlo search
+struct MonteCarloOptions {
+    // playouts over every thread, used when there's no time limit
+    int playouts = MCTS_DEFAULT_PLAYOUTS;
+    // time budget in milliseconds, 0 runs the playouts
+    int timeLimitMs = 0;
+    // threads, each growing its own tree
+    int threads = 1;
+    // the pool size of each tree
+    uint32_t nodes = MCTS_DEFAULT_NODES;
+};
+
+// what a Monte Carlo search found
+struct MonteCarloResult {
+    std::pair<int, int> move = {-1, -1};
+    // playouts over every thread
+    uint64_t playouts = 0;
+    // the chosen move's win rate for the player to move, 0 to 1
+    double winRate = 0.0;
+    // the deepest node of any tree, in plies from the root
+    int depth = 0;
+};
+
+// a node of the tree, the position after its move
+struct MonteCarloNode {
+    // the move that leads here, row -1 for a pass
+    Move move;
+    uint32_t parent;
+    // children are consecutive in the pool, MCTS_NO_NODE until expanded
+    uint32_t firstChild;
+    uint16_t childCount;
+    // the player who made the move
+    uint8_t player;
+    // neither player can move
+    bool terminal;
+    uint32_t visits;
+    // wins for player, a draw counts a half
+    float wins;
+};
+
+
+template <typename BoardType>
+class MonteCarloTree {
+private:
+    BoardType& board;
+    std::vector<MonteCarloNode> pool;
+    uint32_t capacity;
+    // the moves of the current iteration, taken back at the end
+    std::vector<Move> played;
+    Random random;
+    int maxDepth = 0;
+
+    // adds a node to the pool
+    uint32_t addNode(const Move& move, uint32_t parent, int player) {
+        MonteCarloNode node;
+        node.move = move;
+        node.parent = parent;
+        node.firstChild = MCTS_NO_NODE;
+        node.childCount = 0;
+        node.player = static_cast<uint8_t>(player);
+        node.terminal = false;
+        node.visits = 0;
+        node.wins = 0.0f;
+        pool.push_back(node);
+        return static_cast<uint32_t>(pool.size() - 1);
+    }
+
+    // a move that passes the turn
+    static Move passMove() {
+        Move move = {};
+        move.row = -1;
+        move.col = -1;
+        return move;
+    }
+
+    // adds a child for every move of the player after the node, if there's room
+    //
+    // parameters:
+    // uint32_t index - the node, its position is on the board
+    //
+    // returns:
+    // bool - false if the pool is full
+    bool expand(uint32_t index) {
+        int toMove = (pool[index].player == 1) ? 2 : 1;
+        MoveList moves = board.getValidMoves(toMove);
+        size_t needed = moves.empty() ? 1 : moves.size();
+        if (pool.size() + needed > capacity) {
+            return false;
+        }
+        uint32_t first = static_cast<uint32_t>(pool.size());
+        if (!moves.empty()) {
+            for (const Move& move : moves) {
+                addNode(move, index, toMove);
+            }
+        } else if (board.countValidMoves(pool[index].player) > 0) {
+            addNode(passMove(), index, toMove);
+        } else {
+            pool[index].terminal = true;
+            return true;
+        }
+        pool[index].firstChild = first;
+        pool[index].childCount = static_cast<uint16_t>(pool.size() - first);
+        return true;
+    }
+
+    // picks the child with the best UCT score, an untried one first
+    uint32_t selectChild(uint32_t index) const {
+        const MonteCarloNode& node = pool[index];
+        double logVisits = std::log(static_cast<double>(std::max<uint32_t>(node.visits, 1)));
+        uint32_t best = node.firstChild;
+        double bestScore = -1.0;
+        for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child) {
+            const MonteCarloNode& candidate = pool[child];
+            if (candidate.visits == 0) {
+                return child;
+            }
+            double score = candidate.wins / candidate.visits +
+                           MCTS_EXPLORATION * std::sqrt(logVisits / candidate.visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = child;
+            }
+        }
+        return best;
+    }
+
+    // makes a move of the tree or a playout on the board
+    void play(const Move& move, int player) {
+        if (move.row >= 0) {
+            board.placePiece(move, player);
+        }
+        played.push_back(move);
+    }
+
+    // plays random moves until neither player can move
+    //
+    // parameters:
+    // int toMove - the player to move
+    //
+    // returns:
+    // void - does not return a value
+    void playout(int toMove) {
+        bool passed = false;
+        while (true) {
+            MoveList moves = board.getValidMoves(toMove);
+            if (moves.empty()) {
+                if (passed) {
+                    return;
+                }
+                passed = true;
+            } else {
+                passed = false;
+                play(moves[random.below(moves.size())], toMove);
+            }
+            toMove = (toMove == 1) ? 2 : 1;
+        }
+    }
+
+public:
+    // starts a tree for the position on the board
+    //
+    // parameters:
+    // BoardType& searchBoard - the position, moves are made and taken back on it
+    // const MoveList& validMoves - the moves of the player to move, the root's children
+    // int player - the player to move
+    // uint32_t nodes - the size of the pool, at least the root and its children
+    // uint64_t seed - seeds the playouts
+    MonteCarloTree(BoardType& searchBoard, const MoveList& validMoves, int player, uint32_t nodes, uint64_t seed)
+        : board(searchBoard), capacity(std::max<uint32_t>(nodes, validMoves.size() + 1)), random(seed) {
+        pool.reserve(capacity);
+        played.reserve(board.getMaxBoardSize() * board.getMaxBoardSize() * 2);
+        // the root's move is the opponent's, so its children are the player's
+        addNode(passMove(), MCTS_NO_NODE, (player == 1) ? 2 : 1);
+        for (const Move& move : validMoves) {
+            addNode(move, 0, player);
+        }
+        pool[0].firstChild = 1;
+        pool[0].childCount = static_cast<uint16_t>(validMoves.size());
+    }
+
+    // runs one selection, expansion, playout and update
+    //
+    // returns:
+    // void - does not return a value
+    void iterate() {
+        uint32_t index = 0;
+        int depth = 0;
+        // walk down to a leaf
+        while (pool[index].firstChild != MCTS_NO_NODE) {
+            index = selectChild(index);
+            play(pool[index].move, pool[index].player);
+            ++depth;
+        }
+        // grow the tree by one level under a leaf that has been visited
+        if (!pool[index].terminal && pool[index].visits > 0 && expand(index) && pool[index].firstChild != MCTS_NO_NODE) {
+            index = selectChild(index);
+            play(pool[index].move, pool[index].player);
+            ++depth;
+        }
+        maxDepth = std::max(maxDepth, depth);
+
+        if (!pool[index].terminal) {
+            playout((pool[index].player == 1) ? 2 : 1);
+        }
+        int xCount = board.countPieces(1);
+        int oCount = board.countPieces(2);
+        int winner = (xCount > oCount) ? 1 : (oCount > xCount) ? 2 : 0;
+
+        // take every move back, the last one first
+        for (size_t i = played.size(); i-- > 0;) {
+            if (played[i].row >= 0) {
+                board.undoMove(played[i], board.getBoardPlaceValue(played[i].position()));
+            }
+        }
+        played.clear();
+
+        for (uint32_t node = index; node != MCTS_NO_NODE; node = pool[node].parent) {
+            pool[node].visits++;
+            if (winner == 0) {
+                pool[node].wins += 0.5f;
+            } else if (winner == pool[node].player) {
+                pool[node].wins += 1.0f;
+            }
+        }
+    }
+
+    // retrieves a child of the root
+    //
+    // parameters:
+    // int i - the move's index in the root's valid moves
+    //
+    // returns:
+    // const MonteCarloNode& - the child
+    const MonteCarloNode& rootChild(int i) const {
+        return pool[1 + i];
+    }
+
+    // retrieves the deepest node reached, in plies from the root
+    int depthReached() const {
+        return maxDepth;
+    }
+};
+
+
+// searches a position with Monte Carlo tree search and picks the most visited move
+//
+// parameters:
+// const MoveList& validMoves - the valid moves of the player to move
+// BoardType& board - the position, unchanged when this returns
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// const MonteCarloOptions& options - the playouts or time budget, threads and pool size
+//
+// returns:
+// MonteCarloResult - the move and what the search did
+//
+// throws:
+// std::runtime_error if there are no valid moves
+
+template <typename BoardType>
+inline MonteCarloResult monteCarloSearch(
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    const MonteCarloOptions& options
+) {
+    if (validMoves.empty()) {
+        throw std::runtime_error("There are no moves to search.");
+    }
+    MonteCarloResult result;
+    if (validMoves.size() == 1) {
+        result.move = validMoves[0].position();
+        return result;
+    }
+
+    int threadCount = std::max(options.threads, 1);
+    bool timed = options.timeLimitMs > 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeLimitMs);
+    std::atomic<int> playoutsLeft(std::max(options.playouts, 1));
+    std::atomic<uint64_t> playouts(0);
+    std::atomic<int> depth(0);
+
+    // the visits and wins of the root's children, added up over the threads
+    std::vector<uint64_t> visits(validMoves.size(), 0);
+    std::vector<double> wins(validMoves.size(), 0.0);
+    std::mutex resultMutex;
+    // drawn from the caller's generator, so a seeded run plays the same playouts
+    uint64_t seed = threadRandom()();
+
+    auto grow = [&](BoardType& threadBoard, int thread) {
+        MonteCarloTree<BoardType> tree(threadBoard, validMoves, currentPlayer, options.nodes,
+                                       seed + static_cast<uint64_t>(thread));
+        uint64_t count = 0;
+        while (timed ? std::chrono::steady_clock::now() < deadline || count == 0
+                     : playoutsLeft.fetch_sub(1, std::memory_order_relaxed) > 0) {
+            tree.iterate();
+            ++count;
+        }
+        playouts.fetch_add(count, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(resultMutex);
+        for (int i = 0; i < validMoves.size(); ++i) {
+            visits[i] += tree.rootChild(i).visits;
+            wins[i] += tree.rootChild(i).wins;
+        }
+        depth.store(std::max(depth.load(), tree.depthReached()));
+    };
+
+    // every helper gets its own board, copied before the main thread starts
+    std::vector<BoardType> helperBoards(threadCount - 1, board);
+    std::vector<std::thread> helpers;
+    for (int thread = 1; thread < threadCount; ++thread) {
+        helpers.emplace_back([&, thread]() {
+            // a helper's playouts are only extra, a failure in one must not end the game
+            try {
+                grow(helperBoards[thread - 1], thread);
+            } catch (const std::exception&) {
+            }
+        });
+    }
+    grow(board, 0);
+    for (auto& thread : helpers) {
+        thread.join();
+    }
+
+    int best = 0;
+    for (int i = 1; i < validMoves.size(); ++i) {
+        if (visits[i] > visits[best]) {
+            best = i;
+        }
+    }
+    result.move = validMoves[best].position();
+    result.playouts = playouts.load();
+    result.winRate = visits[best] > 0 ? wins[best] / visits[best] : 0.0;
+    result.depth = depth.load();
+    return result;
+}
+
+#endif /* MONTECARLOSEARCH_H */
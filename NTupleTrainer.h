@@ -0,0 +1,199 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: N-Tuple Weight Training
+ *
+ * Produces the weights file NTupleWeights maps. Games are played by the
+ * AI against itself (with a small chance of a random move, so the games
+ * vary), every position is recorded from the point of view of
+ * the player to move along with the final disc difference from that
+ * player's point of view, and the pattern weights are fitted to it:
+ *
+ *   prediction = sum of the weights of every pattern placement in the
+ *                position's phase
+ *   error      = final disc difference - prediction
+ *   each weight used += learningRate * error
+ *
+ * repeated over every recorded position for a few epochs in a shuffled
+ * order. The weights are then written in 1/NTUPLE_SCALE disc units.
+ *
+ */
+
+#ifndef NTUPLETRAINER_H
+#define NTUPLETRAINER_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+// include search implementation
+#include "Search.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include n-tuple weights implementation
+#include "NTupleWeights.h"
+
+
+// settings for a training run
+struct NTupleTrainingOptions {
+    // games to record
+    int games = 1000;
+    int boardSize = 8;
+    // search used by both players to play the games
+    SearchOptions search;
+    size_t ttMegabytes = 64;
+    int phases = NTUPLE_DEFAULT_PHASES;
+    // chance in percent of a random move while recording, so the games vary
+    int randomMovePercent = 10;
+    // passes over the recorded positions
+    int epochs = 3;
+    double learningRate = 0.005;
+};
+
+// what a training run did
+struct NTupleTrainingResult {
+    int games = 0;
+    uint64_t positions = 0;
+    // mean absolute error in discs over the last epoch
+    double meanError = 0.0;
+    double seconds = 0.0;
+};
+
+
+// plays games, fits the pattern weights to their results and writes the weights file
+//
+// parameters:
+// const NTupleTrainingOptions& options - the games, board size, search and fitting settings
+// const std::string& path - the weights file to write
+//
+// returns:
+// NTupleTrainingResult - the games, positions and final error
+//
+// throws:
+// std::invalid_argument if the options are out of range or the board is too small for the patterns
+// std::runtime_error if the file can't be written
+
+inline NTupleTrainingResult trainNTupleWeights(const NTupleTrainingOptions& options, const std::string& path) {
+    if (options.games < 1 || options.epochs < 1 || options.learningRate <= 0.0 ||
+        options.phases < 1 || options.phases > NTUPLE_MAX_PHASES) {
+        throw std::invalid_argument("Training needs at least 1 game, 1 epoch, 1 phase and a positive learning rate.");
+    }
+    std::vector<NTupleInstance> instances = ntupleInstances(options.boardSize);
+    size_t instanceCount = instances.size();
+    auto start = std::chrono::steady_clock::now();
+
+    // the table index of every placement of every recorded position, its phase and its result
+    std::vector<uint32_t> indices;
+    std::vector<uint8_t> phases;
+    std::vector<float> targets;
+
+    SearchOptions search = options.search;
+    search.randomMovePercent = options.randomMovePercent;
+    // stored moves would play every opening the same way
+    search.positionStore = nullptr;
+    TranspositionTable table(options.ttMegabytes);
+    for (int game = 0; game < options.games; ++game) {
+        Board board(options.boardSize);
+        int currentPlayer = 1;
+        bool prevPlayerMoved = true;
+        // the player to move in each position of this game
+        std::vector<int> movers;
+
+        while (true) {
+            MoveList validMoves = board.getValidMoves(currentPlayer);
+            if (validMoves.empty()) {
+                if (!prevPlayerMoved) {
+                    break;
+                }
+                prevPlayerMoved = false;
+                currentPlayer = (currentPlayer == 1) ? 2 : 1;
+                continue;
+            }
+
+            for (const auto& instance : instances) {
+                indices.push_back(static_cast<uint32_t>(ntupleIndex(board, instance, currentPlayer)));
+            }
+            phases.push_back(static_cast<uint8_t>(
+                ntuplePhase(board.countPieces(1) + board.countPieces(2), options.boardSize, options.phases)));
+            movers.push_back(currentPlayer);
+
+            std::pair<int, int> move = getAIMove(validMoves, board, currentPlayer, table, search);
+            board.placePiece(*validMoves.find(move), currentPlayer);
+            prevPlayerMoved = true;
+            currentPlayer = (currentPlayer == 1) ? 2 : 1;
+        }
+
+        int xDiscs = board.countPieces(1) - board.countPieces(2);
+        for (int mover : movers) {
+            targets.push_back(static_cast<float>((mover == 1) ? xDiscs : -xDiscs));
+        }
+    }
+
+    // one table per pattern per phase, phase by phase like the file
+    size_t tableCount = static_cast<size_t>(NTUPLE_PATTERN_COUNT) * options.phases;
+    std::vector<std::vector<float>> weights(tableCount);
+    for (size_t t = 0; t < tableCount; ++t) {
+        weights[t].assign(ntupleTableSize(NTUPLE_PATTERNS[t % NTUPLE_PATTERN_COUNT].squareCount), 0.0f);
+    }
+
+    NTupleTrainingResult result;
+    result.games = options.games;
+    result.positions = targets.size();
+
+    std::vector<size_t> order(targets.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    uint64_t shuffleState = 1;
+    for (int epoch = 0; epoch < options.epochs; ++epoch) {
+        // a fixed shuffle so runs on the same games give the same weights
+        for (size_t i = order.size(); i > 1; --i) {
+            shuffleState = splitMix64(shuffleState);
+            std::swap(order[i - 1], order[shuffleState % i]);
+        }
+
+        double totalError = 0.0;
+        for (size_t sample : order) {
+            const uint32_t* sampleIndices = indices.data() + sample * instanceCount;
+            std::vector<float>* phaseWeights = weights.data() + phases[sample] * NTUPLE_PATTERN_COUNT;
+            float prediction = 0.0f;
+            for (size_t i = 0; i < instanceCount; ++i) {
+                prediction += phaseWeights[instances[i].pattern][sampleIndices[i]];
+            }
+            float error = targets[sample] - prediction;
+            totalError += std::fabs(error);
+            float step = static_cast<float>(options.learningRate) * error;
+            for (size_t i = 0; i < instanceCount; ++i) {
+                phaseWeights[instances[i].pattern][sampleIndices[i]] += step;
+            }
+        }
+        result.meanError = order.empty() ? 0.0 : totalError / order.size();
+    }
+
+    // store in 1/NTUPLE_SCALE discs
+    std::vector<std::vector<int16_t>> tables(tableCount);
+    for (size_t t = 0; t < tableCount; ++t) {
+        tables[t].resize(weights[t].size());
+        for (size_t i = 0; i < weights[t].size(); ++i) {
+            float scaled = std::round(weights[t][i] * NTUPLE_SCALE);
+            scaled = std::max<float>(std::numeric_limits<int16_t>::min(),
+                                     std::min<float>(std::numeric_limits<int16_t>::max(), scaled));
+            tables[t][i] = static_cast<int16_t>(scaled);
+        }
+    }
+    writeNTupleWeights(path, options.boardSize, options.phases, tables);
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+#endif /* NTUPLETRAINER_H */
@@ -0,0 +1,347 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: N-Tuple Pattern Weights
+ *
+ * An n-tuple evaluation looks at fixed groups of squares (patterns) near
+ * the corners and edges. Each pattern's squares read as a base 3 number
+ * (0 empty, 1 the player to move, 2 the opponent) that indexes a table of
+ * weights, and the score is the sum of the weights of every pattern on
+ * the board.
+ *
+ * The patterns are given relative to the corner at (0, 0) and placed at
+ * every corner, and for patterns that aren't symmetric about the corner's
+ * diagonal also mirrored across it, every placement shares its pattern's
+ * table. They need a board of at least 8x8.
+ *
+ * corner3x3 - the 3x3 block in the corner
+ * corner2x5 - the two outer rows, 5 squares along the edge
+ * edgeX     - the first 8 squares of the edge and the X-square
+ * line2     - the first 8 squares of the second row
+ * diagonal  - 8 squares of the diagonal from the corner
+ *
+ * The game is split into phases by the number of discs on the board and
+ * every phase has its own tables, a corner pattern isn't worth the same
+ * in the opening and the endgame.
+ *
+ * The weights are trained for one board size (see NTupleTrainer.h) and
+ * stored in a binary file that is memory mapped read-only, so loading it
+ * parses nothing and every process using it shares the page cache copy
+ *
+ *   NTupleFileHeader (28 bytes)
+ *   uint32_t squareCount per pattern
+ *   int16_t weights, 3^squareCount per pattern, pattern by pattern for
+ *   phase 0, then phase 1, ...
+ *
+ * Values are stored in the machine's byte order (little endian on every
+ * target the game builds for). The weights are in 1/NTUPLE_SCALE of a
+ * disc of final disc difference.
+ *
+ */
+
+#ifndef NTUPLEWEIGHTS_H
+#define NTUPLEWEIGHTS_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+// include memory mapped file implementation
+#include "MappedFile.h"
+
+
+// first bytes of a weights file
+const char NTUPLE_MAGIC[8] = {'O', 'T', 'H', 'N', 'T', 'U', 'P', 'L'};
+const uint32_t NTUPLE_VERSION = 1;
+// weight units per disc
+const int NTUPLE_SCALE = 16;
+// squares in the largest pattern
+const int NTUPLE_MAX_SQUARES = 10;
+// smallest board the patterns fit on
+const int NTUPLE_MIN_BOARD_SIZE = 8;
+// game phases with their own tables
+const int NTUPLE_DEFAULT_PHASES = 4;
+const int NTUPLE_MAX_PHASES = 64;
+
+// the start of a weights file
+struct NTupleFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t boardSize;
+    uint32_t patternCount;
+    uint32_t phaseCount;
+    // where the weight tables start, from the start of the file
+    uint32_t weightsOffset;
+};
+
+// a group of squares relative to the corner at (0, 0)
+struct NTuplePattern {
+    const char* name;
+    int squareCount;
+    std::pair<int, int> squares[NTUPLE_MAX_SQUARES];
+    // mirroring across the corner's diagonal gives the same squares, so it isn't placed twice
+    bool diagonalSymmetric;
+};
+
+const NTuplePattern NTUPLE_PATTERNS[] = {
+    {"corner3x3", 9, {{0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1}, {1, 2}, {2, 0}, {2, 1}, {2, 2}}, true},
+    {"corner2x5", 10, {{0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0}, {1, 1}, {1, 2}, {1, 3}, {1, 4}}, false},
+    {"edgeX", 9, {{0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6}, {0, 7}, {1, 1}}, false},
+    {"line2", 8, {{1, 0}, {1, 1}, {1, 2}, {1, 3}, {1, 4}, {1, 5}, {1, 6}, {1, 7}}, false},
+    {"diagonal", 8, {{0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 6}, {7, 7}}, true}
+};
+const int NTUPLE_PATTERN_COUNT = sizeof(NTUPLE_PATTERNS) / sizeof(NTUPLE_PATTERNS[0]);
+
+// one placement of a pattern on the board
+struct NTupleInstance {
+    int pattern;
+    int squareCount;
+    std::pair<int, int> squares[NTUPLE_MAX_SQUARES];
+};
+
+
+// number of entries in a pattern's table
+//
+// parameters:
+// int squareCount - squares in the pattern
+//
+// returns:
+// size_t - 3 ^ squareCount
+inline size_t ntupleTableSize(int squareCount) {
+    size_t entries = 1;
+    for (int i = 0; i < squareCount; ++i) {
+        entries *= 3;
+    }
+    return entries;
+}
+
+
+// places every pattern at every corner of a board
+//
+// parameters:
+// int boardSize - the size of the board
+//
+// returns:
+// std::vector<NTupleInstance> - every placement
+//
+// throws:
+// std::invalid_argument if the board is smaller than 8x8
+inline std::vector<NTupleInstance> ntupleInstances(int boardSize) {
+    if (boardSize < NTUPLE_MIN_BOARD_SIZE) {
+        throw std::invalid_argument("N-tuple patterns need a board of at least 8x8.");
+    }
+    int last = boardSize - 1;
+    std::vector<NTupleInstance> instances;
+    for (int p = 0; p < NTUPLE_PATTERN_COUNT; ++p) {
+        const NTuplePattern& pattern = NTUPLE_PATTERNS[p];
+        for (int corner = 0; corner < 4; ++corner) {
+            for (int mirror = 0; mirror < (pattern.diagonalSymmetric ? 1 : 2); ++mirror) {
+                NTupleInstance instance;
+                instance.pattern = p;
+                instance.squareCount = pattern.squareCount;
+                for (int i = 0; i < pattern.squareCount; ++i) {
+                    int row = pattern.squares[i].first;
+                    int col = pattern.squares[i].second;
+                    if (mirror) {
+                        std::swap(row, col);
+                    }
+                    // corners 1 and 3 are on the right, 2 and 3 at the bottom
+                    instance.squares[i] = {(corner & 2) ? last - row : row, (corner & 1) ? last - col : col};
+                }
+                instances.push_back(instance);
+            }
+        }
+    }
+    return instances;
+}
+
+
+// the phase of a position
+//
+// parameters:
+// int discs - pieces on the board
+// int boardSize - the size of the board
+// int phaseCount - the number of phases
+//
+// returns:
+// int - the phase, 0 to phaseCount - 1
+inline int ntuplePhase(int discs, int boardSize, int phaseCount) {
+    return std::min(phaseCount - 1, discs * phaseCount / (boardSize * boardSize));
+}
+
+
+// reads the squares of a placement as an index into its pattern's table
+//
+// parameters:
+// const BoardType& board - the position
+// const NTupleInstance& instance - the placement
+// int player - the player to move, whose pieces read as 1
+//
+// returns:
+// size_t - the table index
+template <typename BoardType>
+inline size_t ntupleIndex(const BoardType& board, const NTupleInstance& instance, int player) {
+    size_t index = 0;
+    for (int i = 0; i < instance.squareCount; ++i) {
+        int value = board.getBoardPlaceValue(instance.squares[i]);
+        index = index * 3 + ((value == 0) ? 0 : (value == player) ? 1 : 2);
+    }
+    return index;
+}
+
+
+// writes a weights file
+//
+// parameters:
+// const std::string& path - the file to write
+// int boardSize - the board size the weights were trained for
+// int phaseCount - the number of phases
+// const std::vector<std::vector<int16_t>>& tables - one table per pattern per phase, phase by phase
+//
+// returns:
+// void - does not return a value
+//
+// throws:
+// std::invalid_argument if a table has the wrong size
+// std::runtime_error if the file can't be written
+inline void writeNTupleWeights(
+    const std::string& path,
+    int boardSize,
+    int phaseCount,
+    const std::vector<std::vector<int16_t>>& tables
+) {
+    if (phaseCount < 1 || phaseCount > NTUPLE_MAX_PHASES ||
+        static_cast<int>(tables.size()) != NTUPLE_PATTERN_COUNT * phaseCount) {
+        throw std::invalid_argument("One weight table per pattern per phase is needed.");
+    }
+    NTupleFileHeader header;
+    std::memcpy(header.magic, NTUPLE_MAGIC, sizeof(header.magic));
+    header.version = NTUPLE_VERSION;
+    header.boardSize = boardSize;
+    header.patternCount = NTUPLE_PATTERN_COUNT;
+    header.phaseCount = phaseCount;
+    header.weightsOffset = sizeof(NTupleFileHeader) + NTUPLE_PATTERN_COUNT * sizeof(uint32_t);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int p = 0; p < NTUPLE_PATTERN_COUNT; ++p) {
+        uint32_t squareCount = NTUPLE_PATTERNS[p].squareCount;
+        out.write(reinterpret_cast<const char*>(&squareCount), sizeof(squareCount));
+    }
+    for (size_t t = 0; t < tables.size(); ++t) {
+        const NTuplePattern& pattern = NTUPLE_PATTERNS[t % NTUPLE_PATTERN_COUNT];
+        if (tables[t].size() != ntupleTableSize(pattern.squareCount)) {
+            throw std::invalid_argument(std::string("Wrong table size for pattern ") + pattern.name);
+        }
+        out.write(reinterpret_cast<const char*>(tables[t].data()), tables[t].size() * sizeof(int16_t));
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+
+// a memory mapped weights file, shared read-only by every search thread
+class NTupleWeights {
+private:
+    MappedFile file;
+    int boardSize;
+    int phaseCount;
+    // the start of each pattern's table inside the mapping, phase by phase
+    std::vector<const int16_t*> tables;
+    std::vector<NTupleInstance> instances;
+
+public:
+    // maps a weights file and checks it matches the patterns
+    //
+    // parameters:
+    // const std::string& path - the file written by writeNTupleWeights
+    //
+    // throws:
+    // std::runtime_error if the file can't be mapped or isn't a valid weights file
+    explicit NTupleWeights(const std::string& path) : file(path), boardSize(0), phaseCount(0) {
+        const uint8_t* bytes = file.data();
+        NTupleFileHeader header;
+        if (file.size() < sizeof(header)) {
+            throw std::runtime_error(path + " is not an n-tuple weights file.");
+        }
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, NTUPLE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != NTUPLE_VERSION ||
+            header.patternCount != static_cast<uint32_t>(NTUPLE_PATTERN_COUNT) ||
+            header.boardSize < static_cast<uint32_t>(NTUPLE_MIN_BOARD_SIZE) ||
+            header.phaseCount < 1 || header.phaseCount > static_cast<uint32_t>(NTUPLE_MAX_PHASES) ||
+            header.weightsOffset % alignof(int16_t) != 0) {
+            throw std::runtime_error(path + " is not a weights file for these patterns.");
+        }
+
+        // the square counts
+        for (int p = 0; p < NTUPLE_PATTERN_COUNT; ++p) {
+            uint32_t squareCount;
+            size_t countOffset = sizeof(header) + p * sizeof(uint32_t);
+            if (countOffset + sizeof(squareCount) > file.size()) {
+                throw std::runtime_error(path + " is truncated.");
+            }
+            std::memcpy(&squareCount, bytes + countOffset, sizeof(squareCount));
+            if (squareCount != static_cast<uint32_t>(NTUPLE_PATTERNS[p].squareCount)) {
+                throw std::runtime_error(path + " was written for different patterns.");
+            }
+        }
+
+        // then the tables back to back
+        size_t offset = header.weightsOffset;
+        for (uint32_t t = 0; t < header.phaseCount * NTUPLE_PATTERN_COUNT; ++t) {
+            size_t tableBytes = ntupleTableSize(NTUPLE_PATTERNS[t % NTUPLE_PATTERN_COUNT].squareCount) * sizeof(int16_t);
+            if (offset + tableBytes > file.size()) {
+                throw std::runtime_error(path + " is truncated.");
+            }
+            tables.push_back(reinterpret_cast<const int16_t*>(bytes + offset));
+            offset += tableBytes;
+        }
+
+        boardSize = header.boardSize;
+        phaseCount = header.phaseCount;
+        instances = ntupleInstances(boardSize);
+    }
+
+    // retrieves the board size the weights were trained for
+    //
+    // returns:
+    // int - the board size
+    int getBoardSize() const {
+        return boardSize;
+    }
+
+    // sums the weights of every pattern placement
+    //
+    // parameters:
+    // const BoardType& board - the position, the same size as the weights
+    // int player - the player to move
+    //
+    // returns:
+    // int - the score from the player's point of view, NTUPLE_SCALE per disc
+    template <typename BoardType>
+    int score(const BoardType& board, int player) const {
+        int phase = ntuplePhase(board.countPieces(1) + board.countPieces(2), boardSize, phaseCount);
+        const int16_t* const* phaseTables = tables.data() + phase * NTUPLE_PATTERN_COUNT;
+        int total = 0;
+        for (const auto& instance : instances) {
+            total += phaseTables[instance.pattern][ntupleIndex(board, instance, player)];
+        }
+        return total;
+    }
+};
+
+#endif /* NTUPLEWEIGHTS_H */
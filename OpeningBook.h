@@ -0,0 +1,149 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Opening Book Builder
+ *
+ * Fills a position store (see PositionStore.h) with the best move of every
+ * position reachable in the first plies of a game. The positions are
+ * visited a ply at a time from the starting position, following every
+ * valid move (and passes), each distinct position once. Every position is
+ * searched with the given search options and no random moves, its best
+ * move and score are appended as a BOOK record.
+ *
+ * Positions already in the store at the same or a greater depth are not
+ * searched again, so an interrupted build picks up where it stopped and a
+ * deeper book can be built over a shallower one.
+ *
+ */
+
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+// include search implementation
+#include "Search.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include persistent position store implementation
+#include "PositionStore.h"
+
+
+// what a book build did
+struct OpeningBookResult {
+    // distinct positions with a move in the first plies
+    uint64_t positions = 0;
+    // positions searched and appended, the rest were already stored
+    uint64_t added = 0;
+    double seconds = 0.0;
+};
+
+
+// searches every position of the first plies and appends the best moves to the store
+//
+// parameters:
+// PositionStore& store - the store to fill
+// int boardSize - the size of the board
+// int plies - positions up to this many plies from the start are stored
+// const SearchOptions& search - the search used for each position
+// TranspositionTable& table - the cache of board scores used by the searches
+//
+// returns:
+// OpeningBookResult - the positions visited and added
+//
+// throws:
+// std::invalid_argument if the plies, depth or board size are out of range
+// std::runtime_error if the store can't be written
+
+inline OpeningBookResult buildOpeningBook(
+    PositionStore& store,
+    int boardSize,
+    int plies,
+    const SearchOptions& search,
+    TranspositionTable& table
+) {
+    if (plies < 1 || search.maxDepth < 1 || search.maxDepth > 255 || boardSize > POSITION_STORE_MAX_BOARD_SIZE) {
+        throw std::invalid_argument("The book needs at least 1 ply, a depth of 1 to 255 and a board of at most 255x255.");
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // the book's own moves are searched, not looked up, and never random
+    SearchOptions bookSearch = search;
+    bookSearch.positionStore = nullptr;
+    bookSearch.randomMovePercent = 0;
+    bookSearch.timeLimitMs = 0;
+
+    OpeningBookResult result;
+    // the positions of the current ply and the player to move in each
+    std::vector<std::pair<Board, int>> layer;
+    layer.emplace_back(Board(boardSize), 1);
+    std::unordered_set<uint64_t> seen;
+
+    for (int ply = 0; ply < plies && !layer.empty(); ++ply) {
+        std::vector<std::pair<Board, int>> next;
+        for (auto& position : layer) {
+            Board& board = position.first;
+            int player = position.second;
+            MoveList validMoves = board.getValidMoves(player);
+            if (validMoves.empty()) {
+                // a pass, the same board with the other player to move
+                int opponent = (player == 1) ? 2 : 1;
+                if (board.countValidMoves(opponent) > 0 && seen.insert(positionStoreKey(board, opponent).key).second) {
+                    next.emplace_back(board, opponent);
+                }
+                continue;
+            }
+            ++result.positions;
+
+            SymmetricKey key = positionStoreKey(board, player);
+            PositionRecord stored;
+            bool known = store.lookup(key.key, stored) && (stored.kind == PositionKind::ENDGAME ||
+                                                       stored.depth >= bookSearch.maxDepth);
+            if (!known) {
+                SearchInfo info;
+                std::pair<int, int> move = getAIMove(validMoves, board, player, table, bookSearch, &info);
+                // the move is stored for the canonical image of the board
+                move = key.toKey(move);
+                PositionRecord record = {};
+                record.key = key.key;
+                record.score = static_cast<int16_t>(std::max(-32767, std::min(32767, info.bestScore)));
+                record.row = static_cast<uint8_t>(move.first);
+                record.col = static_cast<uint8_t>(move.second);
+                record.kind = PositionKind::BOOK;
+                record.depth = static_cast<uint8_t>(bookSearch.maxDepth);
+                if (store.append(record)) {
+                    ++result.added;
+                }
+            }
+
+            // every reply leads to a position of the next ply
+            if (ply + 1 == plies) {
+                continue;
+            }
+            for (const Move& move : validMoves) {
+                Board child = board;
+                child.placePiece(move, player);
+                int opponent = (player == 1) ? 2 : 1;
+                if (seen.insert(positionStoreKey(child, opponent).key).second) {
+                    next.emplace_back(std::move(child), opponent);
+                }
+            }
+        }
+        layer.swap(next);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+#endif /* OPENINGBOOK_H */
@@ -0,0 +1,337 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Persistent Position Store
+ *
+ * The transposition table is lost when the process exits, the store keeps
+ * positions across runs: an opening book of the best move for positions
+ * of the first plies (see OpeningBook.h) and solved endgame positions.
+ * getAIMove looks the position up before searching and plays the stored
+ * move when there is one.
+ *
+ * The file is a header followed by fixed size records, new records are
+ * only ever appended, so a crash can at most leave a partial last record,
+ * which is ignored
+ *
+ *   PositionStoreHeader (16 bytes)
+ *   PositionRecord (16 bytes) ...
+ *
+ * Values are stored in the machine's byte order. When a key appears more
+ * than once the last record wins.
+ *
+ * The file is memory mapped read-only and the records are read in place,
+ * nothing is parsed when the store is opened. The index of the records
+ * (an open addressing table of record numbers keyed by position) is built
+ * on the first lookup. Records appended while the store is open are kept
+ * in memory as well as written to the file.
+ *
+ * Keys are the canonical zobrist key of the board (the smallest over its
+ * 8 rotations and reflections, see Symmetry.h), the side to move and the
+ * board size, so one file can hold positions of every board size and a
+ * position and its mirror images share one record. The stored move is
+ * kept for the canonical image and mapped back to the board by the
+ * caller. The stored
+ * move is checked against the valid moves before it's played, a key
+ * collision can't make the AI play an illegal move.
+ *
+ * Lookups and appends lock the store, so the self-play threads can share
+ * one.
+ *
+ */
+
+#ifndef POSITIONSTORE_H
+#define POSITIONSTORE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+// include memory mapped file implementation
+#include "MappedFile.h"
+// include board symmetry implementation
+#include "Symmetry.h"
+
+
+// first bytes of a store file
+const char POSITION_STORE_MAGIC[8] = {'O', 'T', 'H', 'S', 'T', 'O', 'R', 'E'};
+// version 2 keys positions by their canonical image
+const uint32_t POSITION_STORE_VERSION = 2;
+// largest board whose squares fit in a record
+const int POSITION_STORE_MAX_BOARD_SIZE = 255;
+
+// what a record holds
+enum class PositionKind : uint8_t {
+    // the best move found by a search of the record's depth
+    BOOK = 1,
+    // the exact result, the depth is the number of empty squares
+    ENDGAME = 2
+};
+
+// the start of a store file
+struct PositionStoreHeader {
+    char magic[8];
+    uint32_t version;
+    // sizeof(PositionRecord) when the file was written
+    uint32_t recordSize;
+};
+
+// one stored position
+struct PositionRecord {
+    // see positionStoreKey
+    uint64_t key;
+    // the score of the move from the point of view of the player to move
+    int16_t score;
+    // the move on the canonical image of the board
+    uint8_t row;
+    uint8_t col;
+    PositionKind kind;
+    uint8_t depth;
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(PositionStoreHeader) == 16, "the store header is 16 bytes");
+static_assert(sizeof(PositionRecord) == 16, "store records are 16 bytes");
+
+
+// the key of a position in the store
+//
+// parameters:
+// const BoardType& board - the position
+// int player - the player to move
+//
+// returns:
+// SymmetricKey - the board's canonical key mixed with the side to move and the board size,
+//                and the symmetry that maps the board's squares to the stored ones
+template <typename BoardType>
+inline SymmetricKey positionStoreKey(const BoardType& board, int player) {
+    SymmetricKey result = canonicalKey(board);
+    result.key ^= zobristSideKey(player) ^ splitMix64(~uint64_t(board.getMaxBoardSize()));
+    return result;
+}
+
+
+class PositionStore {
+private:
+    std::string path;
+    std::mutex mutex;
+
+    // the records that were in the file when it was opened, read in place
+    std::unique_ptr<MappedFile> file;
+    const PositionRecord* mappedRecords = nullptr;
+    size_t mappedCount = 0;
+    // the records appended since
+    std::vector<PositionRecord> appendedRecords;
+    std::ofstream out;
+
+    // record number + 1 of every key, 0 for an empty slot, a power of two in size
+    std::vector<uint32_t> slots;
+    size_t indexedKeys = 0;
+    bool indexBuilt = false;
+
+    // retrieves a record by its number
+    //
+    // parameters:
+    // size_t number - the record number, file records first
+    //
+    // returns:
+    // const PositionRecord& - the record
+    const PositionRecord& recordAt(size_t number) const {
+        return (number < mappedCount) ? mappedRecords[number] : appendedRecords[number - mappedCount];
+    }
+
+    // finds the slot of a key
+    //
+    // parameters:
+    // uint64_t key - the key to look for
+    //
+    // returns:
+    // size_t - the slot holding the key, or the empty slot where it goes
+    size_t findSlot(uint64_t key) const {
+        size_t mask = slots.size() - 1;
+        size_t slot = static_cast<size_t>(splitMix64(key)) & mask;
+        while (slots[slot] != 0 && recordAt(slots[slot] - 1).key != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    // adds a record to the index, replacing an earlier record with the same key
+    //
+    // parameters:
+    // size_t number - the record number
+    //
+    // returns:
+    // void - does not return a value
+    void indexRecord(size_t number) {
+        // keep the table at most half full
+        if ((indexedKeys + 1) * 2 > slots.size()) {
+            std::vector<uint32_t> old;
+            old.swap(slots);
+            slots.assign(std::max<size_t>(1024, old.size() * 2), 0);
+            for (uint32_t entry : old) {
+                if (entry != 0) {
+                    slots[findSlot(recordAt(entry - 1).key)] = entry;
+                }
+            }
+        }
+        size_t slot = findSlot(recordAt(number).key);
+        if (slots[slot] == 0) {
+            ++indexedKeys;
+        }
+        slots[slot] = static_cast<uint32_t>(number + 1);
+    }
+
+    // builds the index of the file's records on first use
+    //
+    // returns:
+    // void - does not return a value
+    void buildIndex() {
+        if (indexBuilt) {
+            return;
+        }
+        slots.assign(1024, 0);
+        for (size_t i = 0; i < mappedCount; ++i) {
+            indexRecord(i);
+        }
+        indexBuilt = true;
+    }
+
+public:
+    // opens a store, the file is created on the first append if it doesn't exist
+    //
+    // parameters:
+    // const std::string& storePath - the store file
+    //
+    // throws:
+    // std::runtime_error if the file exists but isn't a store file
+    explicit PositionStore(const std::string& storePath) : path(storePath) {
+        if (!std::ifstream(path, std::ios::binary)) {
+            return;
+        }
+        file.reset(new MappedFile(path));
+        if (file->size() == 0) {
+            return;
+        }
+        PositionStoreHeader header;
+        if (file->size() < sizeof(header)) {
+            throw std::runtime_error(path + " is not a position store.");
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, POSITION_STORE_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(path + " is not a position store.");
+        }
+        if (header.version != POSITION_STORE_VERSION || header.recordSize != sizeof(PositionRecord)) {
+            throw std::runtime_error(path + " was written by another version.");
+        }
+        // the mapping is page aligned and the records start after the 16 byte header
+        mappedRecords = reinterpret_cast<const PositionRecord*>(file->data() + sizeof(header));
+        mappedCount = (file->size() - sizeof(header)) / sizeof(PositionRecord);
+    }
+
+    // the store owns its file and lock
+    PositionStore(const PositionStore&) = delete;
+    PositionStore& operator=(const PositionStore&) = delete;
+
+    // looks a position up
+    //
+    // parameters:
+    // uint64_t key - the position's positionStoreKey
+    // PositionRecord& record - set to the stored record if there is one
+    //
+    // returns:
+    // bool - true if the position is stored
+    bool lookup(uint64_t key, PositionRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buildIndex();
+        size_t slot = findSlot(key);
+        if (slots[slot] == 0) {
+            return false;
+        }
+        record = recordAt(slots[slot] - 1);
+        return true;
+    }
+
+    // appends a record to the file, unless the same move is already stored at least as deep
+    //
+    // parameters:
+    // const PositionRecord& record - the record to add
+    //
+    // returns:
+    // bool - true if it was written
+    //
+    // throws:
+    // std::runtime_error if the file can't be written
+    bool append(const PositionRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buildIndex();
+        size_t slot = findSlot(record.key);
+        if (slots[slot] != 0) {
+            const PositionRecord& stored = recordAt(slots[slot] - 1);
+            // an exact result is never replaced by a book move
+            bool better = (record.kind == PositionKind::ENDGAME && stored.kind == PositionKind::BOOK) ||
+                          (record.kind == stored.kind && record.depth > stored.depth);
+            if (!better) {
+                return false;
+            }
+        }
+
+        if (!out.is_open()) {
+            // drop a partial record left by a crash, so the new ones line up
+            std::error_code error;
+            uintmax_t fileSize = std::filesystem::file_size(path, error);
+            if (!error && fileSize > sizeof(PositionStoreHeader) &&
+                (fileSize - sizeof(PositionStoreHeader)) % sizeof(PositionRecord) != 0) {
+                std::filesystem::resize_file(path, sizeof(PositionStoreHeader) + mappedCount * sizeof(PositionRecord), error);
+                if (error) {
+                    throw std::runtime_error("Cannot remove the partial record at the end of " + path);
+                }
+            }
+            out.open(path, std::ios::binary | std::ios::app);
+            if (!out) {
+                throw std::runtime_error("Cannot write " + path);
+            }
+            // a new file starts with the header
+            out.seekp(0, std::ios::end);
+            if (out.tellp() == 0) {
+                PositionStoreHeader header;
+                std::memcpy(header.magic, POSITION_STORE_MAGIC, sizeof(header.magic));
+                header.version = POSITION_STORE_VERSION;
+                header.recordSize = sizeof(PositionRecord);
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            }
+        }
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+
+        appendedRecords.push_back(record);
+        indexRecord(mappedCount + appendedRecords.size() - 1);
+        return true;
+    }
+
+    // retrieves the number of stored positions
+    //
+    // returns:
+    // size_t - the distinct keys in the store
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        buildIndex();
+        return indexedKeys;
+    }
+};
+
+#endif /* POSITIONSTORE_H */
@@ -0,0 +1,190 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Seedable Random Numbers
+ *
+ * The AI's random choices (the random move getAIMove plays some of the
+ * time, the MCTS playouts) draw from a xoshiro256** generator instead of
+ * std::rand. Every thread has its own generator, so threads never share
+ * random state, and nothing is reseeded from the clock, so two games
+ * started in the same second no longer play the same.
+ *
+ * Every generator is derived from one process wide seed, set with
+ * setRandomSeed (--seed N) or picked at random on first use. A thread's
+ * generator is seeded the first time the thread uses it, from the seed
+ * and the order the threads first asked for one. Code that hands out
+ * work across threads can reseed the thread's generator per item with
+ * seedThreadRandom, so an item's random choices depend only on the seed
+ * and the item and not on which thread ran it or what it ran before.
+ *
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <limits>
+
+// include board implementation
+#include "Board.h"
+
+
+// xoshiro256** by Blackman and Vigna, 256 bits of state and 64 bit results
+class Random {
+private:
+    uint64_t state[4];
+
+    static uint64_t rotateLeft(uint64_t x, int bits) {
+        return (x << bits) | (x >> (64 - bits));
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit Random(uint64_t seed = 0) {
+        reseed(seed);
+    }
+
+    // sets the state from a seed, every seed gives a different sequence
+    //
+    // parameters:
+    // uint64_t seed - any value
+    //
+    // returns:
+    // void - does not return a value
+    void reseed(uint64_t seed) {
+        // splitmix64 is one to one, so 4 different inputs can't all give 0,
+        // and nearby seeds are mixed first so they share no state words
+        uint64_t mixed = splitMix64(seed);
+        for (int i = 0; i < 4; ++i) {
+            state[i] = splitMix64(mixed + static_cast<uint64_t>(i));
+        }
+    }
+
+    // retrieves the next 64 random bits
+    uint64_t operator()() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t shifted = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= shifted;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+    // retrieves a random number below a bound, with a multiply instead of a
+    // division, the bias is below bound / 2^32
+    //
+    // parameters:
+    // uint32_t bound - the number of values, at least 1
+    //
+    // returns:
+    // uint32_t - a number from 0 to bound - 1
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>(((*this)() >> 32) * bound >> 32);
+    }
+
+    // retrieves true with a chance in percent
+    //
+    // parameters:
+    // int percent - the chance, 0 never and 100 always
+    //
+    // returns:
+    // bool - true percent times out of 100
+    bool chance(int percent) {
+        return static_cast<int>(below(100)) < percent;
+    }
+
+    static constexpr uint64_t min() {
+        return 0;
+    }
+
+    static constexpr uint64_t max() {
+        return std::numeric_limits<uint64_t>::max();
+    }
+};
+
+
+// the process wide seed, 0 until set or first used
+inline std::atomic<uint64_t>& randomSeedState() {
+    static std::atomic<uint64_t> seed(0);
+    return seed;
+}
+
+// the threads that have seeded their generator so far
+inline std::atomic<uint64_t>& randomStreamCounter() {
+    static std::atomic<uint64_t> streams(0);
+    return streams;
+}
+
+// sets the seed every thread's generator is derived from, call it before
+// the threads first draw a number
+//
+// parameters:
+// uint64_t seed - any value but 0, 0 picks one at random
+//
+// returns:
+// void - does not return a value
+inline void setRandomSeed(uint64_t seed) {
+    randomSeedState().store(seed, std::memory_order_relaxed);
+}
+
+// retrieves the seed every thread's generator is derived from
+//
+// returns:
+// uint64_t - the seed, picked at random if none was set
+inline uint64_t randomSeed() {
+    std::atomic<uint64_t>& state = randomSeedState();
+    uint64_t seed = state.load(std::memory_order_relaxed);
+    if (seed == 0) {
+        std::random_device device;
+        uint64_t picked = (static_cast<uint64_t>(device()) << 32) ^ device() ^
+                          static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        picked = splitMix64(picked) | 1;
+        // another thread may have picked one first
+        state.compare_exchange_strong(seed, picked, std::memory_order_relaxed);
+        seed = state.load(std::memory_order_relaxed);
+    }
+    return seed;
+}
+
+// works out the seed of one stream of random numbers
+//
+// parameters:
+// uint64_t stream - the stream, a thread or a work item
+//
+// returns:
+// uint64_t - the seed of the stream's generator
+inline uint64_t randomStreamSeed(uint64_t stream) {
+    return splitMix64(randomSeed() ^ splitMix64(~stream));
+}
+
+// retrieves the calling thread's generator
+//
+// returns:
+// Random& - the generator, seeded on the thread's first call
+inline Random& threadRandom() {
+    thread_local Random random(randomStreamSeed(randomStreamCounter().fetch_add(1, std::memory_order_relaxed)));
+    return random;
+}
+
+// reseeds the calling thread's generator for a work item
+//
+// parameters:
+// uint64_t item - the work item, e.g. the number of a game
+//
+// returns:
+// void - does not return a value
+inline void seedThreadRandom(uint64_t item) {
+    // kept apart from the streams the threads start with
+    threadRandom().reseed(randomStreamSeed(item ^ 0x8000000000000000ull));
+}
+
+#endif /* RANDOM_H */
@@ -0,0 +1,115 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Root Move List
+ *
+ * getAIMove only ever needs the best scored root move or a random one.
+ * The root moves used to go into an AVLTree, which finds the best by
+ * walking to the rightmost node and a random one by copying every node
+ * into a vector first. A position usually has a few dozen moves, so they
+ * are kept in one array sorted by (score, move) instead: inserting shifts
+ * the larger entries up one slot, the best move is the last entry and a
+ * random move is any index, both O(1). The array is an InlineBuffer, so
+ * nothing is allocated up to 64 moves, and a large board's position with
+ * more moves than that spills to the heap instead of failing.
+ *
+ * The order is the AVL tree's in-order order, so the best move (highest
+ * score, ties to the highest row and column) is the same one the tree
+ * picked. AVLTree still works as the root move container of the search
+ * functions, the benchmark compares the two.
+ *
+ */
+
+#ifndef ROOTMOVES_H
+#define ROOTMOVES_H
+
+#include <utility>
+#include <stdexcept>
+
+// include board implementation
+#include "Board.h"
+
+
+class RootMoveList {
+public:
+    // a score and the move (row, column) it belongs to
+    typedef std::pair<int, std::pair<int, int>> ScoredMove;
+
+private:
+    // plain entries, so the array isn't initialized on construction
+    struct Entry {
+        int score;
+        int row;
+        int col;
+    };
+
+    InlineBuffer<Entry, MoveList::INLINE_CAPACITY> moves;
+
+    // orders entries like the pairs they hold
+    static bool less(const Entry& a, const Entry& b) {
+        if (a.score != b.score) {
+            return a.score < b.score;
+        }
+        return (a.row != b.row) ? a.row < b.row : a.col < b.col;
+    }
+
+public:
+    // adds a scored move in sorted position
+    //
+    // parameters:
+    // const ScoredMove& scoredMove - the score and the move
+    //
+    // returns:
+    // void - does not return a value
+    void insert(const ScoredMove& scoredMove) {
+        Entry entry = {scoredMove.first, scoredMove.second.first, scoredMove.second.second};
+        moves.append();
+        int i = moves.size() - 1;
+        while (i > 0 && less(entry, moves[i - 1])) {
+            moves[i] = moves[i - 1];
+            --i;
+        }
+        moves[i] = entry;
+    }
+
+    // retrieves the move with the highest score
+    //
+    // returns:
+    // ScoredMove - the last entry
+    //
+    // throws:
+    // std::runtime_error if the list is empty
+    ScoredMove best() const {
+        if (moves.empty()) {
+            throw std::runtime_error("The root move list is empty.");
+        }
+        return (*this)[moves.size() - 1];
+    }
+
+    // retrieves a move by its position in score order
+    //
+    // parameters:
+    // int index - 0 for the lowest score, size() - 1 for the highest
+    //
+    // returns:
+    // ScoredMove - the entry
+    ScoredMove operator[](int index) const {
+        return {moves[index].score, {moves[index].row, moves[index].col}};
+    }
+
+    int size() const {
+        return moves.size();
+    }
+
+    bool empty() const {
+        return moves.empty();
+    }
+
+    void clear() {
+        moves.clear();
+    }
+};
+
+#endif /* ROOTMOVES_H */
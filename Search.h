@@ -0,0 +1,1161 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: AI Search Implementation
+ *
+ * Scores are negamax style: a move is worth its own score minus the best
+ * the opponent can do in reply, so every ply maximizes
+ * moveScore - childScore from the point of view of the player to move.
+ * The evaluator (see Evaluator.h) gives a move's own score and scores the
+ * leaves, with the original FLIPS evaluator a move is worth the pieces it
+ * flips and leaves are 0, the default POSITIONAL one scores the leaves.
+ *
+ * Three search modes are available
+ *
+ * MINIMAX    - visits every child at every ply (populateMoveTree), kept as
+ *              the reference ALPHA_BETA has to agree with
+ * ALPHA_BETA - negamax with alpha-beta pruning and the transposition table
+ *              bounds, moves are ordered by the cached best move, corners,
+ *              then flip count so cutoffs happen early
+ * MCTS       - Monte Carlo tree search (see MonteCarloSearch.h) for a
+ *              number of playouts or a time budget, it doesn't use the
+ *              evaluator, the depth or the transposition table, so its
+ *              move and scores aren't held to either of the other two
+ *
+ * Every search plays moves on the board it is given and takes them back
+ * with undoMove, so the board is unchanged when they return and no node
+ * copies it.
+ *
+ * MINIMAX and ALPHA_BETA return the same score for the best root move,
+ * only the number of nodes visited differs. Root moves that can't beat
+ * the best move are stored in the move tree with an upper bound instead
+ * of their exact score, which doesn't change findBestMove or
+ * getRandomMove. MCTS is outside this, it ranks moves by playout results
+ * and can pick a move neither of them would.
+ *
+ * With a time limit the alpha-beta search runs iterative deepening:
+ * depth 1, 2, 3, ... each iteration searching the root moves in the order
+ * of the previous iteration's scores and reusing the transposition table
+ * (so the best move of every node is tried first). When the time runs out
+ * the unfinished iteration is thrown away and the deepest completed one
+ * is used, depth 1 is always completed so there is always a move.
+ *
+ * With more than one thread the alpha-beta search uses Lazy SMP: helper
+ * threads run the same iterative deepening search on their own copy of
+ * the board, starting at staggered depths and with the root moves rotated,
+ * and share the lock-free transposition table with the main thread. They
+ * don't report moves, they only fill the table so the main search gets
+ * more cutoffs and better move ordering. When the main search finishes
+ * the helpers are stopped. Scores cached by a helper at a greater depth
+ * can be used by the main search, so with threads the result is no longer
+ * guaranteed to match minimax at that depth.
+ *
+ * The search functions are templates on the board type. getAIMove copies
+ * 6x6, 8x8, 10x10 and 12x12 boards into a FixedBoard of that size (see
+ * FixedBoard.h) and searches the copy, other sizes, or any size without
+ * options.fixedBoards, search the Board itself. Both generate the same
+ * moves in the same order with the same zobrist keys, so the chosen move
+ * and the table entries don't depend on which one ran.
+ *
+ * With a position store (see PositionStore.h) getAIMove looks the position
+ * up first and plays the stored book move or endgame result without
+ * searching.
+ *
+ * With options.endgameEmpties or fewer empty squares getAIMove solves the
+ * game to the end instead (see EndgameSolver.h) and plays the move with
+ * the best final disc difference, never a random one. The result goes
+ * into the position store. With a time limit the solver gets half of it,
+ * if the solve isn't done by then the heuristic search runs with the time
+ * that is left. Without one the solver gets options.endgameNodes nodes and
+ * the heuristic search runs if they're not enough.
+ *
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <utility>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <cmath>
+
+// include avttree implementation
+#include "AVLTree.h"
+// include root move list implementation
+#include "RootMoves.h"
+// include board implementation
+#include "Board.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include the opt-in search counters
+#include "SearchStats.h"
+// include fixed size board implementation
+#include "FixedBoard.h"
+// include evaluation implementation
+#include "Evaluator.h"
+// include persistent position store implementation
+#include "PositionStore.h"
+// include exact endgame solver implementation
+#include "EndgameSolver.h"
+// include monte carlo tree search implementation
+#include "MonteCarloSearch.h"
+// include board symmetry implementation
+#include "Symmetry.h"
+// include random number implementation
+#include "Random.h"
+
+
+// which search getAIMove runs
+enum class SearchMode {
+    MINIMAX,
+    ALPHA_BETA,
+    MCTS
+};
+
+// settings for the AI search
+struct SearchOptions {
+    SearchMode mode = SearchMode::ALPHA_BETA;
+    // plies to search from the root
+    // with a time limit this is the deepest iteration that will be started
+    int maxDepth = 3;
+    // per move time budget in milliseconds, 0 searches to maxDepth without a limit
+    // a time limit always uses iterative deepening alpha-beta
+    int timeLimitMs = 0;
+    // search threads for alpha-beta, helpers beyond the first use Lazy SMP
+    int threads = 1;
+    // search a FixedBoard copy when the board size has one, false searches the Board as is
+    bool fixedBoards = true;
+    // how leaves and moves are scored
+    EvaluatorKind evaluator = EvaluatorKind::POSITIONAL;
+    // pattern weights for the NTUPLE evaluator, shared by every search
+    const NTupleWeights* ntupleWeights = nullptr;
+    // chance in percent that getAIMove plays a random move instead of the best one
+    int randomMovePercent = 50;
+    // opening book and solved endgames consulted before searching, nullptr for none
+    PositionStore* positionStore = nullptr;
+    // empty squares at or below which the game is solved exactly, 0 never solves
+    int endgameEmpties = ENDGAME_DEFAULT_EMPTIES;
+    // nodes a solve may visit without a time limit, 0 for no limit
+    uint64_t endgameNodes = ENDGAME_DEFAULT_NODES;
+    // start a new table generation for each move, searches sharing a table in a batch age it once instead
+    bool ageTable = true;
+    // MCTS playouts per move when there's no time limit
+    int mctsPlayouts = MCTS_DEFAULT_PLAYOUTS;
+    // MCTS tree nodes per thread
+    uint32_t mctsNodes = MCTS_DEFAULT_NODES;
+};
+
+// score larger than any reachable score, used as the initial window
+const int SEARCH_INFINITY = std::numeric_limits<int>::max() / 2;
+
+// deepest iteration started when only a time limit is given
+const int ITERATIVE_MAX_DEPTH = 64;
+
+// nodes between clock checks
+const uint64_t SEARCH_CLOCK_INTERVAL = 1024;
+
+// tracks the nodes visited and the time budget of a search
+struct SearchControl {
+    uint64_t nodes = 0;
+    bool timed = false;
+    bool stopped = false;
+    std::chrono::steady_clock::time_point deadline;
+    // set by another thread to stop this search, nullptr if none
+    const std::atomic<bool>* abort = nullptr;
+
+    // counts a node and checks the clock every SEARCH_CLOCK_INTERVAL nodes
+    //
+    // returns:
+    // bool - true once the time budget is used up or the search was aborted
+    bool visitNode() {
+        ++nodes;
+        if (abort && abort->load(std::memory_order_relaxed)) {
+            stopped = true;
+        }
+        if (timed && !stopped && nodes % SEARCH_CLOCK_INTERVAL == 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            stopped = true;
+        }
+        return stopped;
+    }
+};
+
+// what a search found, for reporting
+struct SearchInfo {
+    int depthReached = 0;
+    int bestScore = 0;
+    uint64_t nodes = 0;
+};
+
+
+// populates the root move container with moves and their scores using a minimax approach,
+// considering the difference between ai_flips and player_flips across depths.
+//
+// caching is used to optimize recursive evaluation by reusing cached scores
+// for board states.
+// if a board state (and side to move) has been evaluated to an equal or greater
+// remaining depth, the cached score is used. for the root level (depth == 0),
+// the move tree
+// is always rebuilt to ensure consistency, even if a cached score is available.
+//
+// parameters:
+// MoveTree& moveTree - the root move container to populate, a RootMoveList or an AVLTree
+// const MoveList& validMoves - valid moves and their flips
+// BoardType& board - the current game board state
+// int currentPlayer - the current player (1 for X, 2 for O)
+// int depth - the current recursion depth
+// int maxDepth - the maximum recursion depth
+// TranspositionTable& table - the cache of board scores
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// uint64_t* nodeCount - incremented for every node visited if not nullptr
+//
+// returns:
+// int - the best move's score at this level, from currentPlayer's point of view
+
+template <typename MoveTree, typename BoardType, typename Evaluator>
+inline int populateMoveTree(
+    MoveTree& moveTree,
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    int depth,
+    int maxDepth,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    uint64_t* nodeCount = nullptr
+) {
+    if (nodeCount) {
+        ++*nodeCount;
+    }
+    OTHELLO_STAT(searchStats().recordNode(depth));
+    int opponent = (currentPlayer == 1) ? 2 : 1;
+
+    // check if we've reached the maximum depth or there are no valid moves
+    if (depth == maxDepth || validMoves.empty()) {
+        // score the position with the evaluator
+        return evaluator.evaluate(board, currentPlayer, validMoves);
+    }
+
+    // calculate the board hash, the side to move is part of the position
+    // mirrored openings share a key, the best square is stored for the keyed position
+    SymmetricKey tableKey = transpositionKey(board, currentPlayer);
+    uint64_t boardHash = tableKey.key;
+    int remainingDepth = maxDepth - depth;
+
+    // check the cache for the board state
+    // the root is always searched so the move tree gets filled
+    TTEntry cached;
+    if (depth > 0 && timedProbe(table, boardHash, cached) &&
+        cached.bound == TTBound::EXACT && cached.depth >= remainingDepth) {
+        // use cached score if depth is sufficient
+        return cached.score;
+    }
+
+    // initialize the best score
+    int bestScore = -SEARCH_INFINITY;
+    // square of the best move, kept in the cache for later searches
+    int bestSquare = -1;
+    int boardSize = board.getMaxBoardSize();
+    OTHELLO_STAT(searchStats().recordExpansion(validMoves.size()));
+
+    // iterate through all valid moves
+    for (const auto& move : validMoves) {
+        // make the move in place, it is taken back after the child is searched
+        timedPlacePiece(board, move, currentPlayer);
+        evaluator.place(move, currentPlayer);
+
+        // calculate the move's own score, the flips it makes for the original scoring
+        int aiFlips = evaluator.moveScore(move);
+
+        // get valid moves for the next player
+        auto nextValidMoves = timedValidMoves(board, opponent);
+
+        // recursively calculate the score for the opponent's response
+        int childScore = populateMoveTree(
+            moveTree,
+            nextValidMoves,
+            board,
+            opponent,
+            depth + 1,
+            maxDepth,
+            table,
+            evaluator,
+            nodeCount
+        );
+        evaluator.undo(move, currentPlayer);
+        timedUndoMove(board, move, currentPlayer);
+
+        // current score for this move
+        // the child score is the opponent's best, so it counts against us
+        int currentScore = aiFlips - childScore;
+
+        // update the best score
+        if (currentScore > bestScore) {
+            bestScore = currentScore;
+            bestSquare = move.row * boardSize + move.col;
+        }
+
+        // add the move to the tree if at the root
+        if (depth == 0) {
+            moveTree.insert({currentScore, move.position()});
+        }
+    }
+
+    // update the cache with the best score and depth
+    table.store(boardHash, remainingDepth, bestScore, TTBound::EXACT, tableKey.toKeySquare(bestSquare));
+
+    return bestScore;
+}
+
+
+// sorts moves so the ones most likely to cause a cutoff are searched first:
+// the cached best move, then corners, then the most flips
+// an insertion sort is used since lists are short and it keeps equal moves in board order
+//
+// parameters:
+// MoveList& moves - the moves to sort
+// int boardSize - the size of the board
+// int cachedSquare - square index of the cached best move, -1 if none
+//
+// returns:
+// void - does not return a value
+
+inline void orderMoves(MoveList& moves, int boardSize, int cachedSquare) {
+    int last = boardSize - 1;
+
+    // higher is searched first
+    auto priority = [&](const Move& move) {
+        int score = move.flipCount;
+        if ((move.row == 0 || move.row == last) && (move.col == 0 || move.col == last)) {
+            score += 1 << 16;
+        }
+        if (move.row * boardSize + move.col == cachedSquare) {
+            score += 1 << 24;
+        }
+        return score;
+    };
+
+    for (int i = 1; i < moves.size(); ++i) {
+        Move current = moves[i];
+        int currentPriority = priority(current);
+        int j = i - 1;
+        while (j >= 0 && priority(moves[j]) < currentPriority) {
+            moves[j + 1] = moves[j];
+            --j;
+        }
+        moves[j + 1] = current;
+    }
+}
+
+
+// negamax search with alpha-beta pruning
+// returns the same score as populateMoveTree for any node that ends up
+// inside the (alpha, beta) window, otherwise a bound on it (fail-soft)
+//
+// parameters:
+// const MoveList& validMoves - valid moves for the current player
+// BoardType& board - the board to search from
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// int remainingDepth - plies left to search
+// int alpha - the score the player to move is already guaranteed
+// int beta - the score the opponent will not allow
+// TranspositionTable& table - the cache of board scores
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// SearchControl& control - node counter and time budget
+//
+// returns:
+// int - the score of the position from currentPlayer's point of view,
+//       meaningless if control.stopped is set
+
+template <typename BoardType, typename Evaluator>
+inline int alphaBeta(
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    int remainingDepth,
+    int alpha,
+    int beta,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    SearchControl& control
+) {
+    // out of time, the caller throws this iteration away
+    if (control.visitNode()) {
+        return 0;
+    }
+    OTHELLO_STAT(searchStats().recordNode(searchStats().rootDepth - remainingDepth));
+
+    // check if we've reached the maximum depth or there are no valid moves
+    if (remainingDepth == 0 || validMoves.empty()) {
+        return evaluator.evaluate(board, currentPlayer, validMoves);
+    }
+
+    int opponent = (currentPlayer == 1) ? 2 : 1;
+    int boardSize = board.getMaxBoardSize();
+    SymmetricKey tableKey = transpositionKey(board, currentPlayer);
+    uint64_t boardHash = tableKey.key;
+
+    // use the cached score if it is deep enough and decides this window
+    TTEntry cached;
+    int cachedSquare = -1;
+    if (timedProbe(table, boardHash, cached)) {
+        cachedSquare = tableKey.fromKeySquare(cached.bestMove);
+        if (cached.depth >= remainingDepth) {
+            if (cached.bound == TTBound::EXACT ||
+                (cached.bound == TTBound::LOWER && cached.score >= beta) ||
+                (cached.bound == TTBound::UPPER && cached.score <= alpha)) {
+                return cached.score;
+            }
+        }
+    }
+
+    // try the likely best moves first
+    MoveList orderedMoves = validMoves;
+    orderMoves(orderedMoves, boardSize, cachedSquare);
+    OTHELLO_STAT(searchStats().recordExpansion(orderedMoves.size()));
+
+    int originalAlpha = alpha;
+    int bestScore = -SEARCH_INFINITY;
+    int bestSquare = -1;
+
+    for (const auto& move : orderedMoves) {
+        timedPlacePiece(board, move, currentPlayer);
+        evaluator.place(move, currentPlayer);
+        MoveList nextValidMoves = timedValidMoves(board, opponent);
+        int moveScore = evaluator.moveScore(move);
+
+        // score = moveScore - child, so the child's window is shifted by the move's score
+        int childScore = alphaBeta(
+            nextValidMoves,
+            board,
+            opponent,
+            remainingDepth - 1,
+            moveScore - beta,
+            moveScore - alpha,
+            table,
+            evaluator,
+            control
+        );
+        evaluator.undo(move, currentPlayer);
+        timedUndoMove(board, move, currentPlayer);
+        if (control.stopped) {
+            // don't let a partial result into the table
+            return 0;
+        }
+        int currentScore = moveScore - childScore;
+
+        if (currentScore > bestScore) {
+            bestScore = currentScore;
+            bestSquare = move.row * boardSize + move.col;
+        }
+        if (bestScore > alpha) {
+            alpha = bestScore;
+        }
+        if (alpha >= beta) {
+            // the opponent won't allow this line
+            break;
+        }
+    }
+
+    // record what kind of score this is
+    TTBound bound = TTBound::EXACT;
+    if (bestScore <= originalAlpha) {
+        bound = TTBound::UPPER;
+    } else if (bestScore >= beta) {
+        bound = TTBound::LOWER;
+    }
+    table.store(boardHash, remainingDepth, bestScore, bound, tableKey.toKeySquare(bestSquare));
+
+    return bestScore;
+}
+
+
+// searches every root move with alpha-beta in the given order
+// each move is searched with alpha just below the best score so far, so any
+// move that ties the best gets its exact score and findBestMove breaks ties
+// the same way populateMoveTree does
+//
+// parameters:
+// const MoveList& orderedMoves - root moves, in the order to search them
+// BoardType& board - the current game board state
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// int maxDepth - plies to search
+// TranspositionTable& table - the cache of board scores
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// SearchControl& control - node counter and time budget
+// std::vector<std::pair<int, std::pair<int, int>>>& rootScores - filled with (score, move) for each root move
+//
+// returns:
+// bool - true if every root move was searched, false if the time ran out
+
+template <typename BoardType, typename Evaluator>
+inline bool searchRootMoves(
+    const MoveList& orderedMoves,
+    BoardType& board,
+    int currentPlayer,
+    int maxDepth,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    SearchControl& control,
+    std::vector<std::pair<int, std::pair<int, int>>>& rootScores
+) {
+    int opponent = (currentPlayer == 1) ? 2 : 1;
+    int boardSize = board.getMaxBoardSize();
+    rootScores.clear();
+
+    int bestScore = -SEARCH_INFINITY;
+    int bestSquare = -1;
+    OTHELLO_STAT(searchStats().rootDepth = maxDepth);
+    OTHELLO_STAT(searchStats().recordNode(0));
+    OTHELLO_STAT(searchStats().recordExpansion(orderedMoves.size()));
+
+    for (const auto& move : orderedMoves) {
+        timedPlacePiece(board, move, currentPlayer);
+        evaluator.place(move, currentPlayer);
+        MoveList nextValidMoves = timedValidMoves(board, opponent);
+        int moveScore = evaluator.moveScore(move);
+
+        // alpha is one below the best so ties are scored exactly
+        int alpha = (bestScore == -SEARCH_INFINITY) ? -SEARCH_INFINITY : bestScore - 1;
+        int childScore = alphaBeta(
+            nextValidMoves,
+            board,
+            opponent,
+            maxDepth - 1,
+            moveScore - SEARCH_INFINITY,
+            moveScore - alpha,
+            table,
+            evaluator,
+            control
+        );
+        evaluator.undo(move, currentPlayer);
+        timedUndoMove(board, move, currentPlayer);
+        if (control.stopped) {
+            return false;
+        }
+        int currentScore = moveScore - childScore;
+
+        if (currentScore > bestScore) {
+            bestScore = currentScore;
+            bestSquare = move.row * boardSize + move.col;
+        }
+        rootScores.push_back({currentScore, move.position()});
+    }
+
+    SymmetricKey tableKey = transpositionKey(board, currentPlayer);
+    uint64_t boardHash = tableKey.key;
+    table.store(boardHash, maxDepth, bestScore, TTBound::EXACT, tableKey.toKeySquare(bestSquare));
+    OTHELLO_STAT(searchStats().recordIteration());
+    return true;
+}
+
+
+// searches every root move with alpha-beta to a fixed depth and adds them to the move tree
+//
+// parameters:
+// MoveTree& moveTree - the root move container to populate, a RootMoveList or an AVLTree
+// const MoveList& validMoves - valid moves for the current player
+// BoardType& board - the current game board state
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// int maxDepth - plies to search
+// TranspositionTable& table - the cache of board scores
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// SearchInfo* info - filled with the search statistics if not nullptr
+//
+// returns:
+// int - the best move's score
+
+template <typename MoveTree, typename BoardType, typename Evaluator>
+inline int populateMoveTreeAlphaBeta(
+    MoveTree& moveTree,
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    int maxDepth,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    SearchInfo* info = nullptr
+) {
+    if (maxDepth == 0 || validMoves.empty()) {
+        return 0;
+    }
+
+    // start with the best move from the last search of this position
+    TTEntry cached;
+    SymmetricKey tableKey = transpositionKey(board, currentPlayer);
+    uint64_t boardHash = tableKey.key;
+    int cachedSquare = table.probe(boardHash, cached) ? tableKey.fromKeySquare(cached.bestMove) : -1;
+    MoveList orderedMoves = validMoves;
+    orderMoves(orderedMoves, board.getMaxBoardSize(), cachedSquare);
+
+    SearchControl control;
+    std::vector<std::pair<int, std::pair<int, int>>> rootScores;
+    searchRootMoves(orderedMoves, board, currentPlayer, maxDepth, table, evaluator, control, rootScores);
+
+    int bestScore = -SEARCH_INFINITY;
+    for (const auto& scoredMove : rootScores) {
+        bestScore = std::max(bestScore, scoredMove.first);
+        moveTree.insert(scoredMove);
+    }
+
+    if (info) {
+        info->depthReached = maxDepth;
+        info->bestScore = bestScore;
+        info->nodes = control.nodes;
+    }
+    return bestScore;
+}
+
+
+// runs iterative deepening from firstDepth until maxDepth is done or the
+// control stops the search, the first iteration is never timed out
+//
+// parameters:
+// MoveList orderedMoves - root moves, in the order to search the first iteration
+// const MoveList& validMoves - valid moves for the current player
+// BoardType& board - the current game board state
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// int firstDepth - the depth of the first iteration
+// int maxDepth - the deepest iteration to start
+// TranspositionTable& table - the cache of board scores
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// SearchControl& control - node counter, time budget and abort flag
+// std::vector<std::pair<int, std::pair<int, int>>>& completedScores - filled with the root scores of the deepest completed iteration
+//
+// returns:
+// int - the deepest completed depth, 0 if none
+
+template <typename BoardType, typename Evaluator>
+inline int deepenRootMoves(
+    MoveList orderedMoves,
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    int firstDepth,
+    int maxDepth,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    SearchControl& control,
+    std::vector<std::pair<int, std::pair<int, int>>>& completedScores
+) {
+    std::vector<std::pair<int, std::pair<int, int>>> rootScores;
+    bool timed = control.timed;
+    int depthReached = 0;
+
+    for (int depth = firstDepth; depth <= maxDepth; ++depth) {
+        // the first iteration always finishes so there is a move to play
+        control.timed = timed && depth > firstDepth;
+        if (!searchRootMoves(orderedMoves, board, currentPlayer, depth, table, evaluator, control, rootScores)) {
+            break;
+        }
+        completedScores.swap(rootScores);
+        depthReached = depth;
+
+        // next iteration searches in order of this iteration's scores, best first
+        // stable so equal scores keep their previous order
+        std::vector<std::pair<int, std::pair<int, int>>> order = completedScores;
+        std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first;
+        });
+        MoveList reordered;
+        for (const auto& scoredMove : order) {
+            reordered.add(*validMoves.find(scoredMove.second));
+        }
+        orderedMoves = reordered;
+
+        if (timed && std::chrono::steady_clock::now() >= control.deadline) {
+            break;
+        }
+    }
+
+    control.timed = timed;
+    return depthReached;
+}
+
+
+// caps a search depth at the number of empty squares
+//
+// parameters:
+// const BoardType& board - the current game board state
+// int maxDepth - the requested depth
+//
+// returns:
+// int - the depth worth searching
+
+template <typename BoardType>
+inline int capDepthAtEmpties(const BoardType& board, int maxDepth) {
+    int boardSize = board.getMaxBoardSize();
+    int emptySquares = boardSize * boardSize - board.countPieces(1) - board.countPieces(2);
+    return std::min(maxDepth, emptySquares);
+}
+
+
+// iterative deepening alpha-beta with a time budget
+// searches depth 1, 2, 3, ... until the time runs out or maxDepth is done
+// and adds the root moves of the deepest completed iteration to the move tree
+//
+// parameters:
+// MoveTree& moveTree - the root move container to populate, a RootMoveList or an AVLTree
+// const MoveList& validMoves - valid moves for the current player
+// BoardType& board - the current game board state
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// int maxDepth - the deepest iteration to start
+// int timeLimitMs - the time budget in milliseconds
+// TranspositionTable& table - the cache of board scores
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// SearchInfo* info - filled with the search statistics if not nullptr
+//
+// returns:
+// int - the best move's score at the deepest completed depth
+
+template <typename MoveTree, typename BoardType, typename Evaluator>
+inline int populateMoveTreeIterative(
+    MoveTree& moveTree,
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    int maxDepth,
+    int timeLimitMs,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    SearchInfo* info = nullptr
+) {
+    if (maxDepth == 0 || validMoves.empty()) {
+        return 0;
+    }
+
+    SearchControl control;
+    control.timed = true;
+    control.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimitMs);
+
+    // no point searching past the end of the game
+    maxDepth = capDepthAtEmpties(board, maxDepth);
+
+    // the first iteration is ordered by the table, like a fixed depth search
+    TTEntry cached;
+    SymmetricKey tableKey = transpositionKey(board, currentPlayer);
+    uint64_t boardHash = tableKey.key;
+    int cachedSquare = table.probe(boardHash, cached) ? tableKey.fromKeySquare(cached.bestMove) : -1;
+    MoveList orderedMoves = validMoves;
+    orderMoves(orderedMoves, board.getMaxBoardSize(), cachedSquare);
+
+    std::vector<std::pair<int, std::pair<int, int>>> completedScores;
+    int depthReached = deepenRootMoves(orderedMoves, validMoves, board, currentPlayer,
+                                       1, maxDepth, table, evaluator, control, completedScores);
+
+    int bestScore = -SEARCH_INFINITY;
+    for (const auto& scoredMove : completedScores) {
+        bestScore = std::max(bestScore, scoredMove.first);
+        moveTree.insert(scoredMove);
+    }
+
+    if (info) {
+        info->depthReached = depthReached;
+        info->bestScore = bestScore;
+        info->nodes = control.nodes;
+    }
+    return bestScore;
+}
+
+
+// Lazy SMP alpha-beta: the main search runs on this thread (fixed depth,
+// or iterative deepening with a time limit) while threads - 1 helpers
+// search the same position and share the transposition table
+//
+// parameters:
+// MoveTree& moveTree - the root move container to populate, a RootMoveList or an AVLTree
+// const MoveList& validMoves - valid moves for the current player
+// BoardType& board - the current game board state
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// const SearchOptions& options - the depth, time limit and thread count
+// TranspositionTable& table - the cache of board scores, shared by every thread
+// Evaluator& evaluator - scores moves and leaves, kept in step with the board
+// SearchInfo* info - filled with the search statistics if not nullptr, nodes counts every thread
+//
+// returns:
+// int - the main search's best move score
+
+template <typename MoveTree, typename BoardType, typename Evaluator>
+inline int populateMoveTreeParallel(
+    MoveTree& moveTree,
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    const SearchOptions& options,
+    TranspositionTable& table,
+    Evaluator& evaluator,
+    SearchInfo* info = nullptr
+) {
+    if (options.maxDepth == 0 || validMoves.empty()) {
+        return 0;
+    }
+
+    int maxDepth = capDepthAtEmpties(board, options.maxDepth);
+    std::atomic<bool> abort(false);
+    std::atomic<uint64_t> helperNodes(0);
+
+    // every helper gets its own board and evaluator, copied before the main search starts
+    std::vector<BoardType> helperBoards(std::max(options.threads - 1, 0), board);
+    std::vector<Evaluator> helperEvaluators(helperBoards.size(), evaluator);
+    std::vector<std::thread> helpers;
+
+    for (int helper = 1; helper < options.threads; ++helper) {
+        helpers.emplace_back([&, helper]() {
+            // the helpers only feed the table, a failure in one must not end the game
+            try {
+                SearchControl control;
+                control.abort = &abort;
+
+                // rotate the root moves so helpers start in different parts of the tree
+                MoveList orderedMoves;
+                for (int i = 0; i < validMoves.size(); ++i) {
+                    orderedMoves.add(validMoves[(i + helper) % validMoves.size()]);
+                }
+
+                // odd helpers start a ply deeper so the depths are staggered
+                std::vector<std::pair<int, std::pair<int, int>>> scores;
+                deepenRootMoves(orderedMoves, validMoves, helperBoards[helper - 1], currentPlayer,
+                                std::min(1 + helper % 2, maxDepth), maxDepth, table, helperEvaluators[helper - 1], control, scores);
+                helperNodes.fetch_add(control.nodes, std::memory_order_relaxed);
+            } catch (const std::exception&) {
+                // nothing to do, the main search doesn't depend on the helpers
+            }
+        });
+    }
+
+    SearchInfo mainInfo;
+    int bestScore;
+    if (options.timeLimitMs > 0) {
+        bestScore = populateMoveTreeIterative(moveTree, validMoves, board, currentPlayer,
+                                              maxDepth, options.timeLimitMs, table, evaluator, &mainInfo);
+    } else {
+        bestScore = populateMoveTreeAlphaBeta(moveTree, validMoves, board, currentPlayer,
+                                              maxDepth, table, evaluator, &mainInfo);
+    }
+
+    // the main search is done, stop the helpers
+    abort.store(true, std::memory_order_relaxed);
+    for (auto& thread : helpers) {
+        thread.join();
+    }
+
+    if (info) {
+        *info = mainInfo;
+        info->nodes += helperNodes.load(std::memory_order_relaxed);
+    }
+    return bestScore;
+}
+
+
+// finds the move with the highest score in the AVL tree by traversing to the rightmost node
+//
+// parameters:
+// AVLNode<std::pair<int, std::pair<int, int>>>* root - the root node of the AVL tree
+//
+// returns:
+// std::pair<int, int> - the move (row, column) with the highest score
+
+inline std::pair<int, int> findBestMove(AVLNode<std::pair<int, std::pair<int, int>>>* root) {
+    // sanity check
+    if (!root) {
+        throw std::runtime_error("The move tree is empty.");
+    }
+
+    // traverse to right most for highest score
+    AVLNode<std::pair<int, std::pair<int, int>>>* current = root;
+    while (current->right != nullptr) {
+        current = current->right;
+    }
+
+    // return the move
+    return current->data.second;
+}
+
+// performs an inorder traversal of the AVL tree and collects all nodes in a vector
+//
+// parameters:
+// AVLNode<std::pair<int, std::pair<int, int>>>* root - the root node of the AVL tree
+// std::vector<std::pair<int, std::pair<int, int>>>& moves - a vector to store the collected moves
+//
+// returns:
+// none
+
+inline void collectInorderMoves(
+    AVLNode<std::pair<int, std::pair<int, int>>>* root,
+    std::vector<std::pair<int, std::pair<int, int>>>& moves
+) {
+    // if we don't have a root
+    // we return and the vector is empty
+    // should never happen
+    if (!root) return;
+
+    collectInorderMoves(root->left, moves);     // left
+    moves.push_back(root->data);               // current
+    collectInorderMoves(root->right, moves);   // right
+}
+
+// selects a random move from the AVL tree by collecting all moves in sorted order
+//
+// parameters:
+// AVLNode<std::pair<int, std::pair<int, int>>>* root - the root node of the AVL tree
+// Random& random - the generator to draw from, the calling thread's by default
+//
+// returns:
+// std::pair<int, int> - a random move (row, column) from the AVL tree
+
+inline std::pair<int, int> getRandomMove(AVLNode<std::pair<int, std::pair<int, int>>>* root,
+                                         Random& random = threadRandom()) {
+    // move tree is empty for some reason
+    // should never happen
+    if (!root) {
+        throw std::runtime_error("The move tree is empty.");
+    }
+
+    // all the moves
+    std::vector<std::pair<int, std::pair<int, int>>> allMoves;
+    // collect the moves into an array
+    collectInorderMoves(root, allMoves);
+
+    // pick a move, any move
+    int randomIndex = random.below(allMoves.size());
+    return allMoves[randomIndex].second; // Return the random move (row, column)
+}
+
+// finds the move with the highest score in the root move list
+//
+// parameters:
+// const RootMoveList& moves - the scored root moves
+//
+// returns:
+// std::pair<int, int> - the move (row, column) with the highest score
+
+inline std::pair<int, int> findBestMove(const RootMoveList& moves) {
+    return moves.best().second;
+}
+
+// selects a random move from the root move list
+//
+// parameters:
+// const RootMoveList& moves - the scored root moves
+// Random& random - the generator to draw from, the calling thread's by default
+//
+// returns:
+// std::pair<int, int> - a random move (row, column) from the list
+
+inline std::pair<int, int> getRandomMove(const RootMoveList& moves, Random& random = threadRandom()) {
+    // should never happen
+    if (moves.empty()) {
+        throw std::runtime_error("The root move list is empty.");
+    }
+
+    // pick a move, any move
+    return moves[random.below(moves.size())].second;
+}
+
+// runs the search the options select and populates the root move container
+//
+// parameters:
+// MoveTree& moveTree - the root move container to populate, a RootMoveList or an AVLTree
+// const MoveList& validMoves - valid moves for the current player
+// BoardType& board - the current game board state
+// int currentPlayer - the player to move (1 for X, 2 for O)
+// TranspositionTable& table - the cache of board scores
+// const SearchOptions& options - the search mode, depth, time limit and threads
+// SearchInfo* info - filled with the search statistics if not nullptr
+//
+// returns:
+// void - does not return a value
+
+template <typename MoveTree, typename BoardType>
+inline void populateMoveTreeWithOptions(
+    MoveTree& moveTree,
+    const MoveList& validMoves,
+    BoardType& board,
+    int currentPlayer,
+    TranspositionTable& table,
+    const SearchOptions& options,
+    SearchInfo* info
+) {
+    withEvaluator(options.evaluator, options.ntupleWeights, [&](auto& evaluator) {
+        evaluator.reset(board);
+        if (options.threads > 1 && options.mode == SearchMode::ALPHA_BETA) {
+            populateMoveTreeParallel(moveTree, validMoves, board, currentPlayer, options, table, evaluator, info);
+        } else if (options.timeLimitMs > 0) {
+            populateMoveTreeIterative(moveTree, validMoves, board, currentPlayer,
+                                      options.maxDepth, options.timeLimitMs, table, evaluator, info);
+        } else if (options.mode == SearchMode::MINIMAX) {
+            uint64_t nodes = 0;
+            int bestScore = populateMoveTree(moveTree, validMoves, board, currentPlayer, 0, options.maxDepth,
+                                             table, evaluator, &nodes);
+            if (info) {
+                info->depthReached = options.maxDepth;
+                info->bestScore = bestScore;
+                info->nodes = nodes;
+            }
+        } else {
+            populateMoveTreeAlphaBeta(moveTree, validMoves, board, currentPlayer, options.maxDepth, table, evaluator, info);
+        }
+    });
+}
+
+// determines the AI's move by populating the root move list with valid moves and selecting the best or random move
+//
+// parameters:
+// const MoveList& validMoves - a list of valid moves and their corresponding flips
+// Board& board - the current game board
+// int currentPlayer - the player the AI is playing as
+// TranspositionTable& table - the cache of board scores shared between moves
+// const SearchOptions& options - the search mode, depth and time limit
+// SearchInfo* info - filled with the search statistics if not nullptr
+//
+// returns:
+// std::pair<int, int> - the selected move (row, column)
+
+inline std::pair<int, int> getAIMove(
+    const MoveList& validMoves,
+    Board& board,
+    int currentPlayer,
+    TranspositionTable& table,
+    const SearchOptions& options,
+    SearchInfo* info = nullptr
+) {
+    // a stored move is played without searching, a book move only if it was
+    // searched at least as deep as this search would go
+    if (options.positionStore && board.getMaxBoardSize() <= POSITION_STORE_MAX_BOARD_SIZE) {
+        PositionRecord stored;
+        SymmetricKey storeKey = positionStoreKey(board, currentPlayer);
+        if (options.positionStore->lookup(storeKey.key, stored) &&
+            (stored.kind == PositionKind::ENDGAME || options.timeLimitMs > 0 || stored.depth >= options.maxDepth)) {
+            // the move was stored for the canonical image of the board
+            std::pair<int, int> storedMove = storeKey.fromKey({stored.row, stored.col});
+            if (validMoves.find(storedMove)) {
+                if (info) {
+                    info->depthReached = stored.depth;
+                    info->bestScore = stored.score;
+                    info->nodes = 0;
+                }
+                return storedMove;
+            }
+        }
+    }
+
+    // close to the end the game is solved exactly, on a fixed size copy of the board if there is one
+    int size = board.getMaxBoardSize();
+    int empties = size * size - board.countPieces(1) - board.countPieces(2);
+    SearchOptions searchOptions = options;
+    if (options.endgameEmpties > 0 && empties <= options.endgameEmpties) {
+        auto start = std::chrono::steady_clock::now();
+        std::pair<int, int> solvedMove;
+        int solvedScore = 0;
+        uint64_t solvedNodes = 0;
+        bool solved = false;
+        auto solveOn = [&](auto& solveBoard) {
+            // with a time limit the solver gets half, so a failed solve leaves time to search
+            int solveMs = (options.timeLimitMs > 0) ? std::max(1, options.timeLimitMs / 2) : 0;
+            uint64_t solveNodes = (options.timeLimitMs > 0) ? 0 : options.endgameNodes;
+            EndgameSolver<std::decay_t<decltype(solveBoard)>> solver(solveBoard, solveMs, solveNodes);
+            solved = solver.solveRoot(currentPlayer, solvedMove, solvedScore);
+            solvedNodes = solver.getNodes();
+        };
+        if (!(options.fixedBoards && withFixedBoard(board, solveOn))) {
+            solveOn(board);
+        }
+
+        if (solved) {
+            if (options.positionStore && size <= POSITION_STORE_MAX_BOARD_SIZE) {
+                SymmetricKey storeKey = positionStoreKey(board, currentPlayer);
+                std::pair<int, int> storedMove = storeKey.toKey(solvedMove);
+                PositionRecord record = {};
+                record.key = storeKey.key;
+                record.score = static_cast<int16_t>(solvedScore);
+                record.row = static_cast<uint8_t>(storedMove.first);
+                record.col = static_cast<uint8_t>(storedMove.second);
+                record.kind = PositionKind::ENDGAME;
+                record.depth = static_cast<uint8_t>(std::min(empties, 255));
+                options.positionStore->append(record);
+            }
+            if (info) {
+                info->depthReached = empties;
+                info->bestScore = solvedScore;
+                info->nodes = solvedNodes;
+            }
+            return solvedMove;
+        }
+
+        // out of time, search with what's left
+        if (options.timeLimitMs > 0) {
+            int elapsedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            searchOptions.timeLimitMs = std::max(1, options.timeLimitMs - elapsedMs);
+        }
+    }
+
+    // monte carlo search picks its move from the playouts, a random one as often as the others do
+    if (options.mode == SearchMode::MCTS) {
+        MonteCarloOptions monteCarlo;
+        monteCarlo.playouts = options.mctsPlayouts;
+        monteCarlo.timeLimitMs = searchOptions.timeLimitMs;
+        monteCarlo.threads = options.threads;
+        monteCarlo.nodes = options.mctsNodes;
+        MonteCarloResult result;
+        bool searchedFixed = options.fixedBoards && withFixedBoard(board, [&](auto& fixedBoard) {
+            result = monteCarloSearch(validMoves, fixedBoard, currentPlayer, monteCarlo);
+        });
+        if (!searchedFixed) {
+            result = monteCarloSearch(validMoves, board, currentPlayer, monteCarlo);
+        }
+        if (info) {
+            info->depthReached = result.depth;
+            info->bestScore = static_cast<int>(std::lround(100.0 * result.winRate));
+            info->nodes = result.playouts;
+        }
+        if (threadRandom().chance(options.randomMovePercent)) {
+            return validMoves[threadRandom().below(validMoves.size())].position();
+        }
+        return result.move;
+    }
+
+    // the scored root moves, a sorted array on the stack
+    RootMoveList moveTree;
+
+    // entries from earlier moves can be replaced
+    if (options.ageTable) {
+        table.newSearch();
+    }
+    OTHELLO_STAT(searchStats().begin(table.getStats()));
+
+    // populate the root move list, on a fixed size copy of the board if there is one
+    bool searchedFixed = options.fixedBoards && withFixedBoard(board, [&](auto& fixedBoard) {
+        populateMoveTreeWithOptions(moveTree, validMoves, fixedBoard, currentPlayer, table, searchOptions, info);
+    });
+    if (!searchedFixed) {
+        populateMoveTreeWithOptions(moveTree, validMoves, board, currentPlayer, table, searchOptions, info);
+    }
+
+    // choose random move or  "best" move
+    // makes the games more "interesting"
+    std::pair<int, int> move;
+    if (threadRandom().chance(options.randomMovePercent)) {
+        // pick a random move
+        move = getRandomMove(moveTree);
+    } else {
+        // pick the "best" move
+        move = findBestMove(moveTree);
+    }
+
+    OTHELLO_STAT(searchStats().emit(std::cerr, currentPlayer,
+                                    options.mode == SearchMode::MINIMAX && options.timeLimitMs == 0 ? "minimax" : "alphabeta",
+                                    move, table.getStats()));
+    return move;
+}
+
+#endif /* SEARCH_H */
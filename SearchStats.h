@@ -0,0 +1,227 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Search Instrumentation
+ *
+ * Opt-in counters for the AI search, built only when OTHELLO_STATS is
+ * defined (make CONF=Release CXXFLAGS=-DOTHELLO_STATS after a clean).
+ * Without it every hook below is an empty macro or a plain forwarding
+ * call, so the normal build has no counters and no clock reads.
+ *
+ * For every getAIMove call the search records
+ *
+ * - nodes visited at each ply from the root
+ * - transposition table probes/hits/misses/overwrites (the difference
+ *   in the table counters over the call, so Lazy SMP helpers are included)
+ * - the average branching factor, validMoves.size() over expanded nodes
+ * - time spent generating moves, probing the table and making/unmaking
+ *   moves (the search no longer hashes from scratch or copies boards,
+ *   these are the operations that replaced them)
+ * - the time at which each iterative deepening iteration completed
+ *
+ * and writes it to stderr as one JSON line per move. The counters are
+ * thread_local, so with --threads only the main search thread's nodes
+ * and timings are reported.
+ *
+ */
+
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+// include board implementation
+#include "Board.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+
+#ifdef OTHELLO_STATS
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <utility>
+
+// plies from the root that get their own node counter, deeper plies share the last one
+const int STATS_MAX_PLY = 64;
+
+// the counters for one getAIMove call
+struct SearchStats {
+    uint64_t nodesPerPly[STATS_MAX_PLY];
+    int deepestPly = 0;
+    // sum of validMoves.size() over expanded nodes, and how many were expanded
+    uint64_t branchTotal = 0;
+    uint64_t expanded = 0;
+    // nanoseconds in each operation
+    uint64_t moveGenNs = 0;
+    uint64_t probeNs = 0;
+    uint64_t makeUnmakeNs = 0;
+    // depth of the iteration the search is in, for alpha-beta ply numbers
+    int rootDepth = 0;
+    // (depth, microseconds since the start) for each completed iteration
+    std::vector<std::pair<int, uint64_t>> iterations;
+    TTStats tableStart;
+    std::chrono::steady_clock::time_point start;
+
+    // resets the counters at the start of a getAIMove call
+    //
+    // parameters:
+    // const TTStats& table - the table counters before the search
+    //
+    // returns:
+    // void - does not return a value
+    void begin(const TTStats& table) {
+        for (int i = 0; i < STATS_MAX_PLY; ++i) {
+            nodesPerPly[i] = 0;
+        }
+        deepestPly = 0;
+        branchTotal = 0;
+        expanded = 0;
+        moveGenNs = 0;
+        probeNs = 0;
+        makeUnmakeNs = 0;
+        rootDepth = 0;
+        iterations.clear();
+        tableStart = table;
+        start = std::chrono::steady_clock::now();
+    }
+
+    // counts a node at a ply from the root
+    void recordNode(int ply) {
+        ply = (ply < 0) ? 0 : (ply >= STATS_MAX_PLY) ? STATS_MAX_PLY - 1 : ply;
+        nodesPerPly[ply]++;
+        if (ply > deepestPly) {
+            deepestPly = ply;
+        }
+    }
+
+    // counts a node whose moves are about to be searched
+    void recordExpansion(int moveCount) {
+        branchTotal += moveCount;
+        expanded++;
+    }
+
+    // notes that the iteration at rootDepth finished
+    void recordIteration() {
+        iterations.push_back({rootDepth, elapsedNs() / 1000});
+    }
+
+    // nanoseconds since begin
+    uint64_t elapsedNs() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    // writes the counters as one JSON object on one line
+    //
+    // parameters:
+    // std::ostream& out - where to write
+    // int player - the player who moved
+    // const char* mode - the search that ran
+    // std::pair<int, int> move - the move chosen
+    // const TTStats& table - the table counters after the search
+    //
+    // returns:
+    // void - does not return a value
+    void emit(std::ostream& out, int player, const char* mode, std::pair<int, int> move, const TTStats& table) const {
+        uint64_t nodes = 0;
+        for (int i = 0; i <= deepestPly; ++i) {
+            nodes += nodesPerPly[i];
+        }
+        uint64_t probes = table.probes - tableStart.probes;
+        uint64_t hits = table.hits - tableStart.hits;
+
+        out << "{\"player\":" << player
+            << ",\"mode\":\"" << mode << "\""
+            << ",\"move\":[" << move.first << "," << move.second << "]"
+            << ",\"nodes\":" << nodes
+            << ",\"nodes_per_ply\":[";
+        for (int i = 0; i <= deepestPly; ++i) {
+            out << (i ? "," : "") << nodesPerPly[i];
+        }
+        out << "],\"tt_probes\":" << probes
+            << ",\"tt_hits\":" << hits
+            << ",\"tt_misses\":" << table.misses - tableStart.misses
+            << ",\"tt_overwrites\":" << table.overwrites - tableStart.overwrites
+            << ",\"tt_hit_rate\":" << (probes ? static_cast<double>(hits) / probes : 0.0)
+            << ",\"branching\":" << (expanded ? static_cast<double>(branchTotal) / expanded : 0.0)
+            << ",\"total_us\":" << elapsedNs() / 1000
+            << ",\"move_gen_us\":" << moveGenNs / 1000
+            << ",\"tt_probe_us\":" << probeNs / 1000
+            << ",\"make_unmake_us\":" << makeUnmakeNs / 1000
+            << ",\"iterations\":[";
+        for (size_t i = 0; i < iterations.size(); ++i) {
+            out << (i ? "," : "") << "{\"depth\":" << iterations[i].first
+                << ",\"us\":" << iterations[i].second << "}";
+        }
+        out << "]}\n";
+    }
+};
+
+// the counters of the search running on this thread
+inline SearchStats& searchStats() {
+    thread_local SearchStats stats;
+    return stats;
+}
+
+// adds the time until it goes out of scope to a counter
+class StatsTimer {
+private:
+    uint64_t& total;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit StatsTimer(uint64_t& counter)
+        : total(counter), start(std::chrono::steady_clock::now()) {}
+
+    ~StatsTimer() {
+        total += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// runs a statement only in an instrumented build
+#define OTHELLO_STAT(statement) statement
+// times the rest of the enclosing scope into one of the SearchStats counters
+#define OTHELLO_STAT_TIMER(counter) StatsTimer statsTimer(searchStats().counter)
+
+#else
+
+#define OTHELLO_STAT(statement) do {} while (0)
+#define OTHELLO_STAT_TIMER(counter) do {} while (0)
+
+#endif /* OTHELLO_STATS */
+
+
+// the board and table operations the search times, plain calls unless
+// OTHELLO_STATS is defined
+
+// generates the valid moves of a position
+template <typename BoardType>
+inline MoveList timedValidMoves(const BoardType& board, int player) {
+    OTHELLO_STAT_TIMER(moveGenNs);
+    return board.getValidMoves(player);
+}
+
+// looks up a position in the transposition table
+inline bool timedProbe(const TranspositionTable& table, uint64_t key, TTEntry& entry) {
+    OTHELLO_STAT_TIMER(probeNs);
+    return table.probe(key, entry);
+}
+
+// plays a move on the search board
+template <typename BoardType>
+inline void timedPlacePiece(BoardType& board, const Move& move, int player) {
+    OTHELLO_STAT_TIMER(makeUnmakeNs);
+    board.placePiece(move, player);
+}
+
+// takes a move back on the search board
+template <typename BoardType>
+inline void timedUndoMove(BoardType& board, const Move& move, int player) {
+    OTHELLO_STAT_TIMER(makeUnmakeNs);
+    board.undoMove(move, player);
+}
+
+#endif /* SEARCHSTATS_H */
@@ -0,0 +1,264 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Headless Self-Play Implementation
+ *
+ * Plays AI vs AI games with no terminal I/O so the engine can be
+ * benchmarked and used to generate games at scale.
+ *
+ * Games are handed out to a pool of worker threads, each worker plays one
+ * game at a time with its own board and its own transposition table, so
+ * workers never share state other than the position store, if there is
+ * one, which locks on every lookup. Every worker keeps its own counters and they
+ * are added up once the workers are done.
+ *
+ * Passes are handled the same way as playGame: a player with no valid
+ * moves passes, and the game ends when both players pass in a row.
+ *
+ * Each game reseeds its worker's random numbers from the run's seed and
+ * the game's number (see Random.h), so the random moves of a game don't
+ * depend on which worker plays it. With options.reproducible each game
+ * also starts from an empty transposition table and endgame table, so a
+ * game's searches don't depend on the games its worker played before and
+ * a run with the same --seed plays the same games at any worker count
+ * (with a --book the store fills in whatever order the games finish, and
+ * lookups can differ).
+ *
+ * With a GameRecordWriter every finished game is recorded, the workers
+ * share the writer.
+ *
+ * With a challenger search the games are a match between two engines:
+ * the challenger plays O in even games and X in odd ones, so both get
+ * each colour equally often, and the wins, moves and thinking time are
+ * counted for each engine as well as for each colour.
+ *
+ */
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+// include board implementation
+#include "Board.h"
+// include search implementation
+#include "Search.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include game record implementation
+#include "GameRecord.h"
+// include random number implementation
+#include "Random.h"
+
+
+// settings for a self-play run
+struct SelfPlayOptions {
+    // games to play
+    int games = 1;
+    int boardSize = 8;
+    // games played at the same time, one thread each
+    int workers = 1;
+    // memory budget of each worker's transposition table
+    size_t ttMegabytes = 64;
+    TTReplacement ttReplacement = TTReplacement::DEPTH_PREFERRED;
+    // search used for both players
+    SearchOptions search;
+    // records every game if not nullptr
+    GameRecordWriter* recorder = nullptr;
+    // plays search against this instead of itself if set
+    bool hasChallenger = false;
+    SearchOptions challenger;
+    // start every game from empty tables so a seeded run plays the same games at any worker count
+    bool reproducible = false;
+};
+
+// totals for a self-play run
+struct SelfPlayResult {
+    int games = 0;
+    int xWins = 0;
+    int oWins = 0;
+    int draws = 0;
+    // moves played, passes aren't counted
+    uint64_t moves = 0;
+    // search nodes over every move
+    uint64_t nodes = 0;
+    // wall clock time of the whole run
+    double seconds = 0.0;
+    // by engine with a challenger, 0 for search and 1 for the challenger
+    int engineWins[2] = {0, 0};
+    uint64_t engineMoves[2] = {0, 0};
+    // time spent in getAIMove
+    double engineSeconds[2] = {0.0, 0.0};
+};
+
+
+// plays one AI vs AI game to the end
+//
+// parameters:
+// int boardSize - the size of the board
+// const SearchOptions& search - the search used for both players
+// TranspositionTable& table - the cache of board scores, kept between games
+// SelfPlayResult& result - the game's moves, nodes and outcome are added to it
+// GameRecordWriter* recorder - records the game if not nullptr
+// const SearchOptions* challenger - the other engine if not nullptr, search is then engine 0
+// bool challengerIsX - the challenger plays X instead of O
+//
+// returns:
+// int - the winner (1 for X, 2 for O, 0 for a draw)
+
+inline int playSelfPlayGame(
+    int boardSize,
+    const SearchOptions& search,
+    TranspositionTable& table,
+    SelfPlayResult& result,
+    GameRecordWriter* recorder = nullptr,
+    const SearchOptions* challenger = nullptr,
+    bool challengerIsX = false
+) {
+    // the engine each player uses, by player - 1
+    int engines[2] = {0, 0};
+    if (challenger) {
+        engines[challengerIsX ? 0 : 1] = 1;
+    }
+    const SearchOptions* searches[2] = {&search, challenger ? challenger : &search};
+
+    Board board(boardSize);
+    int currentPlayer = 1;
+    bool prevPlayerMoved = true;
+    std::vector<PlayerMove> moves;
+
+    while (true) {
+        MoveList validMoves = board.getValidMoves(currentPlayer);
+
+        if (validMoves.empty()) {
+            // neither player can move, the game is over
+            if (!prevPlayerMoved) {
+                break;
+            }
+            prevPlayerMoved = false;
+            currentPlayer = (currentPlayer == 1) ? 2 : 1;
+            continue;
+        }
+
+        SearchInfo info;
+        int engine = engines[currentPlayer - 1];
+        auto moveStart = std::chrono::steady_clock::now();
+        std::pair<int, int> move = getAIMove(validMoves, board, currentPlayer, table, *searches[engine], &info);
+        result.engineSeconds[engine] += std::chrono::duration<double>(std::chrono::steady_clock::now() - moveStart).count();
+        result.engineMoves[engine]++;
+        board.placePiece(*validMoves.find(move), currentPlayer);
+        if (recorder) {
+            moves.push_back(PlayerMove(currentPlayer, move));
+        }
+
+        result.moves++;
+        result.nodes += info.nodes;
+        prevPlayerMoved = true;
+        currentPlayer = (currentPlayer == 1) ? 2 : 1;
+    }
+
+    if (recorder) {
+        recorder->write(boardSize, moves);
+    }
+
+    int xCount = board.countPieces(1);
+    int oCount = board.countPieces(2);
+    int winner = (xCount > oCount) ? 1 : (oCount > xCount) ? 2 : 0;
+
+    result.games++;
+    if (winner == 1) {
+        result.xWins++;
+    } else if (winner == 2) {
+        result.oWins++;
+    } else {
+        result.draws++;
+    }
+    if (winner != 0) {
+        result.engineWins[engines[winner - 1]]++;
+    }
+    return winner;
+}
+
+
+// plays the requested number of games across the worker threads
+//
+// parameters:
+// const SelfPlayOptions& options - the games, board size, workers and search
+//
+// returns:
+// SelfPlayResult - the totals over every game
+//
+// throws:
+// std::invalid_argument if the options are out of range
+// std::runtime_error if a game failed
+
+inline SelfPlayResult runSelfPlay(const SelfPlayOptions& options) {
+    if (options.games < 1 || options.workers < 1 || options.boardSize < 4) {
+        throw std::invalid_argument("Self-play needs at least 1 game, 1 worker and a board of at least 4.");
+    }
+
+    int workerCount = std::min(options.workers, options.games);
+    std::atomic<int> nextGame(0);
+    std::atomic<bool> failed(false);
+    std::vector<SelfPlayResult> workerResults(workerCount);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int worker = 0; worker < workerCount; ++worker) {
+        workers.emplace_back([&, worker]() {
+            try {
+                TranspositionTable table(options.ttMegabytes, options.ttReplacement);
+                // take games until they run out
+                int game;
+                while (!failed.load(std::memory_order_relaxed) &&
+                       (game = nextGame.fetch_add(1, std::memory_order_relaxed)) < options.games) {
+                    seedThreadRandom(static_cast<uint64_t>(game));
+                    if (options.reproducible) {
+                        table.clear();
+                        clearEndgameTable();
+                    }
+                    playSelfPlayGame(options.boardSize, options.search, table, workerResults[worker], options.recorder,
+                                     options.hasChallenger ? &options.challenger : nullptr, game % 2 == 1);
+                }
+            } catch (const std::exception&) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (failed.load()) {
+        throw std::runtime_error("A self-play game failed.");
+    }
+
+    // add up the workers
+    SelfPlayResult total;
+    for (const auto& result : workerResults) {
+        total.games += result.games;
+        total.xWins += result.xWins;
+        total.oWins += result.oWins;
+        total.draws += result.draws;
+        total.moves += result.moves;
+        total.nodes += result.nodes;
+        for (int engine = 0; engine < 2; ++engine) {
+            total.engineWins[engine] += result.engineWins[engine];
+            total.engineMoves[engine] += result.engineMoves[engine];
+            total.engineSeconds[engine] += result.engineSeconds[engine];
+        }
+    }
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+#endif /* SELFPLAY_H */
@@ -0,0 +1,190 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Board Symmetries
+ *
+ * A square board looks the same under 8 symmetries: the identity, the
+ * three rotations and the four reflections. Positions that are each
+ * other's mirror image or rotation have the same score and the same best
+ * move (mapped through the symmetry), so they can share one entry of a
+ * cache. A symmetry is 3 bits, applied in this order
+ *
+ *   4 - swap row and column (reflect in the main diagonal)
+ *   1 - reflect top to bottom
+ *   2 - reflect left to right
+ *
+ * The canonical key of a position is the smallest of the zobrist keys of
+ * its 8 images, the symmetry that gives it is kept with the key so a
+ * stored square can be mapped to the canonical board and back. The
+ * identity's key is the board's own getHash(), so for a position that's
+ * already canonical nothing changes.
+ *
+ * The images' keys are worked out from the pieces, which costs 8 key
+ * lookups per piece, so the transposition table only uses canonical keys
+ * for positions with at most SYMMETRY_TABLE_MAX_PIECES pieces. That's
+ * where mirrored positions meet: the start position is symmetric and so
+ * is every early line's mirror image, while once the pieces spread out a
+ * search almost never reaches two images of one position. Whether a
+ * position is canonicalized depends only on the position, so every
+ * search that reaches it uses the same key. The position store, looked
+ * up once per move, always uses canonical keys.
+ *
+ */
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+#include <utility>
+
+// include board implementation
+#include "Board.h"
+
+
+const int SYMMETRY_COUNT = 8;
+// positions with at most this many pieces get canonical transposition table keys
+const int SYMMETRY_TABLE_MAX_PIECES = 14;
+
+// maps a square to its image under a symmetry
+//
+// parameters:
+// int symmetry - the symmetry, 0 to 7
+// std::pair<int, int> square - the (row, col) of the square
+// int size - the size of the board
+//
+// returns:
+// std::pair<int, int> - the (row, col) of the image
+inline std::pair<int, int> applySymmetry(int symmetry, std::pair<int, int> square, int size) {
+    if (symmetry & 4) {
+        std::swap(square.first, square.second);
+    }
+    if (symmetry & 1) {
+        square.first = size - 1 - square.first;
+    }
+    if (symmetry & 2) {
+        square.second = size - 1 - square.second;
+    }
+    return square;
+}
+
+// maps an image back to the square it came from
+//
+// parameters:
+// int symmetry - the symmetry the image was made with, 0 to 7
+// std::pair<int, int> square - the (row, col) of the image
+// int size - the size of the board
+//
+// returns:
+// std::pair<int, int> - the (row, col) of the original square
+inline std::pair<int, int> undoSymmetry(int symmetry, std::pair<int, int> square, int size) {
+    if (symmetry & 2) {
+        square.second = size - 1 - square.second;
+    }
+    if (symmetry & 1) {
+        square.first = size - 1 - square.first;
+    }
+    if (symmetry & 4) {
+        std::swap(square.first, square.second);
+    }
+    return square;
+}
+
+// a cache key and the symmetry that takes the board to the position it belongs to
+struct SymmetricKey {
+    uint64_t key = 0;
+    // 0 if the key is the board's own
+    int symmetry = 0;
+    int size = 0;
+
+    // maps a square of the board to the keyed position
+    std::pair<int, int> toKey(const std::pair<int, int>& square) const {
+        return applySymmetry(symmetry, square, size);
+    }
+
+    // maps a square of the keyed position back to the board
+    std::pair<int, int> fromKey(const std::pair<int, int>& square) const {
+        return undoSymmetry(symmetry, square, size);
+    }
+
+    // the same for a square index (row * size + col), -1 is kept as no square
+    int toKeySquare(int square) const {
+        if (square < 0 || symmetry == 0) {
+            return square;
+        }
+        std::pair<int, int> image = toKey({square / size, square % size});
+        return image.first * size + image.second;
+    }
+
+    int fromKeySquare(int square) const {
+        if (square < 0 || symmetry == 0) {
+            return square;
+        }
+        std::pair<int, int> original = fromKey({square / size, square % size});
+        return original.first * size + original.second;
+    }
+};
+
+
+// works out the smallest zobrist key of a board's 8 images
+//
+// parameters:
+// const BoardType& board - the position
+//
+// returns:
+// SymmetricKey - the key of the pieces (no side to move) and the symmetry that gives it
+template <typename BoardType>
+inline SymmetricKey canonicalKey(const BoardType& board) {
+    int size = board.getMaxBoardSize();
+    int last = size - 1;
+    uint64_t keys[SYMMETRY_COUNT] = {};
+    board.forEachPiece([&](int row, int col, int player) {
+        // the squares are numbered row * size + col like the board's own key
+        int flippedRow = last - row;
+        int flippedCol = last - col;
+        keys[0] ^= zobristKey(row * size + col, player);
+        keys[1] ^= zobristKey(flippedRow * size + col, player);
+        keys[2] ^= zobristKey(row * size + flippedCol, player);
+        keys[3] ^= zobristKey(flippedRow * size + flippedCol, player);
+        keys[4] ^= zobristKey(col * size + row, player);
+        keys[5] ^= zobristKey(flippedCol * size + row, player);
+        keys[6] ^= zobristKey(col * size + flippedRow, player);
+        keys[7] ^= zobristKey(flippedCol * size + flippedRow, player);
+    });
+
+    SymmetricKey result;
+    result.key = keys[0];
+    result.size = size;
+    for (int symmetry = 1; symmetry < SYMMETRY_COUNT; ++symmetry) {
+        if (keys[symmetry] < result.key) {
+            result.key = keys[symmetry];
+            result.symmetry = symmetry;
+        }
+    }
+    return result;
+}
+
+// works out the key a position is cached under in the transposition table,
+// canonical for positions with at most SYMMETRY_TABLE_MAX_PIECES pieces
+//
+// parameters:
+// const BoardType& board - the position
+// int player - the player to move
+//
+// returns:
+// SymmetricKey - the key, with the side to move, and its symmetry
+template <typename BoardType>
+inline SymmetricKey transpositionKey(const BoardType& board, int player) {
+    SymmetricKey result;
+    if (board.countPieces(1) + board.countPieces(2) <= SYMMETRY_TABLE_MAX_PIECES) {
+        result = canonicalKey(board);
+    } else {
+        result.key = board.getHash();
+        result.size = board.getMaxBoardSize();
+    }
+    result.key ^= zobristSideKey(player);
+    return result;
+}
+
+#endif /* SYMMETRY_H */
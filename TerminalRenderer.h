@@ -0,0 +1,211 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Diff-Based Terminal Renderer
+ *
+ * Draws the interactive game screen. A frame is a list of text lines,
+ * the renderer remembers the last frame it drew and only rewrites the
+ * characters that changed since then: each run of changed characters is
+ * a cursor move (ANSI "\033[row;colH") followed by the new text, and a
+ * line that got shorter is cut with "\033[K". A move on a large board
+ * touches a handful of cells, so a frame is a few dozen bytes instead
+ * of the whole board.
+ *
+ * The whole frame is built in one string and handed to the terminal with
+ * one write, after flushing std::cout so anything printed before comes
+ * out first.
+ *
+ * The last line of a frame is taken to be a prompt and the user's answer
+ * is echoed after it, so it is always rewritten and everything below it
+ * cleared. A frame is drawn in full, after clearing the screen, the
+ * first time, after invalidate(), when the output isn't a terminal, and
+ * when the frame wouldn't fit on the screen (the terminal would scroll or
+ * wrap and the old positions would be wrong).
+ *
+ */
+
+#ifndef TERMINALRENDERER_H
+#define TERMINALRENDERER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+
+// changed characters closer than this are written as one run, a cursor
+// move costs about as much
+const size_t RENDER_RUN_GAP = 8;
+
+class TerminalRenderer {
+private:
+    // the lines on the screen, empty until the first frame
+    std::vector<std::string> shown;
+    bool fullRedraw = true;
+    // the frame being built, kept to reuse its memory
+    std::string output;
+
+    // retrieves the size of the terminal
+    //
+    // parameters:
+    // int& rows - set to the number of rows
+    // int& columns - set to the number of columns
+    //
+    // returns:
+    // bool - false if the output isn't a terminal or its size is unknown
+    static bool terminalSize(int& rows, int& columns) {
+#ifdef _WIN32
+        rows = 0;
+        columns = 0;
+        return false;
+#else
+        struct winsize size;
+        if (!isatty(STDOUT_FILENO) || ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 ||
+            size.ws_row == 0 || size.ws_col == 0) {
+            return false;
+        }
+        rows = size.ws_row;
+        columns = size.ws_col;
+        return true;
+#endif
+    }
+
+    // adds a cursor move to the frame
+    void moveCursor(size_t row, size_t col) {
+        output += "\033[";
+        output += std::to_string(row + 1);
+        output += ';';
+        output += std::to_string(col + 1);
+        output += 'H';
+    }
+
+    // adds the changes of one line to the frame
+    //
+    // parameters:
+    // size_t row - the line's row on the screen
+    // const std::string& before - what the screen shows
+    // const std::string& after - what it should show
+    //
+    // returns:
+    // void - does not return a value
+    void diffLine(size_t row, const std::string& before, const std::string& after) {
+        size_t col = 0;
+        while (col < after.size()) {
+            if (col < before.size() && before[col] == after[col]) {
+                ++col;
+                continue;
+            }
+            // a run of changes, running on over short stretches that match
+            size_t start = col;
+            size_t end = col + 1;
+            size_t look = end;
+            while (look < after.size() && look - end < RENDER_RUN_GAP) {
+                if (look >= before.size() || before[look] != after[look]) {
+                    end = look + 1;
+                }
+                ++look;
+            }
+            moveCursor(row, start);
+            output.append(after, start, end - start);
+            col = end;
+        }
+        if (before.size() > after.size()) {
+            moveCursor(row, after.size());
+            output += "\033[K";
+        }
+    }
+
+    // writes the frame to the terminal
+    void flushOutput() {
+        std::cout.flush();
+#ifdef _WIN32
+        std::fwrite(output.data(), 1, output.size(), stdout);
+        std::fflush(stdout);
+#else
+        size_t written = 0;
+        while (written < output.size()) {
+            ssize_t count = ::write(STDOUT_FILENO, output.data() + written, output.size() - written);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            written += static_cast<size_t>(count);
+        }
+#endif
+    }
+
+public:
+    // draws a frame, the cursor is left at the end of the last line
+    //
+    // parameters:
+    // const std::vector<std::string>& lines - the frame, the last line is a prompt
+    //
+    // returns:
+    // void - does not return a value
+    void render(const std::vector<std::string>& lines) {
+        if (lines.empty()) {
+            return;
+        }
+        output.clear();
+
+        int rows = 0;
+        int columns = 0;
+        bool fits = terminalSize(rows, columns) && lines.size() < static_cast<size_t>(rows);
+        for (size_t i = 0; fits && i < lines.size(); ++i) {
+            fits = lines[i].size() < static_cast<size_t>(columns);
+        }
+
+        if (fullRedraw || !fits) {
+            // clear the screen and set cursor to the upper left
+            output += "\033[2J\033[H";
+            for (size_t i = 0; i < lines.size(); ++i) {
+                output += lines[i];
+                if (i + 1 < lines.size()) {
+                    output += '\n';
+                }
+            }
+        } else {
+            static const std::string empty;
+            for (size_t i = 0; i < lines.size(); ++i) {
+                const std::string& before = (i < shown.size()) ? shown[i] : empty;
+                diffLine(i, before, lines[i]);
+                // the old prompt line holds the user's answer as well
+                if (i + 1 == shown.size() && i + 1 < lines.size() && before.size() <= lines[i].size()) {
+                    moveCursor(i, lines[i].size());
+                    output += "\033[K";
+                }
+            }
+            // leave the cursor after the prompt and clear the answer and the old lines below it
+            moveCursor(lines.size() - 1, lines.back().size());
+            output += "\033[J";
+        }
+
+        flushOutput();
+        shown = lines;
+        // a frame that didn't fit may have scrolled, the next one starts over
+        fullRedraw = !fits;
+    }
+
+    // draws the next frame in full, for when something else wrote to the screen
+    //
+    // returns:
+    // void - does not return a value
+    void invalidate() {
+        fullRedraw = true;
+    }
+};
+
+#endif /* TERMINALRENDERER_H */
@@ -0,0 +1,355 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Transposition Table Implementation
+ *
+ * Fixed size cache of search results keyed by the board's zobrist key
+ * (with the side to move mixed in), replaces the unbounded scoreCache.
+ *
+ * The table is a power of two array of single entry buckets sized from a
+ * memory budget in megabytes, the low bits of the key pick the bucket and
+ * the full key is stored to detect collisions.
+ *
+ * Each entry records the score, the remaining depth it was searched to,
+ * whether the score is exact or only a lower/upper bound, and the best
+ * move found so the search can try it first next time. Scores are kept in
+ * 24 bits, a score beyond that is stored as the bound it still proves
+ * (see store) rather than cut to its low bits.
+ *
+ * Two replacement policies are supported
+ *
+ * DEPTH_PREFERRED - keep the deeper entry unless the stored one is from an
+ *                   older search
+ * ALWAYS_REPLACE  - the newest entry always wins
+ *
+ * hits/misses/collisions/stores/overwrites are counted so the size can be
+ * tuned.
+ *
+ * The table is shared by all search threads without a lock. Each bucket
+ * holds two 64 bit atomics: the entry packed into one word and the key
+ * xor'd with that word. A probe only accepts a bucket whose two words
+ * agree with the key, so an entry torn by two threads writing at once
+ * reads as a miss instead of a wrong score.
+ *
+ * The counters are only for tuning and must not cost the search threads
+ * a shared cache line: each thread counts into its own stripe, a cache
+ * line of counters picked when the thread first touches a table, with a
+ * plain load and store rather than an atomic add. getStats adds the
+ * stripes up. The stripes are handed out round robin, two threads that
+ * get the same one may lose the odd count, which tuning doesn't notice.
+ *
+ */
+
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <array>
+
+// what the stored score means
+enum class TTBound : uint8_t {
+    NONE,   // empty entry
+    EXACT,  // the score is the exact value
+    LOWER,  // the real value is >= score (search failed high)
+    UPPER   // the real value is <= score (search failed low)
+};
+
+// the largest score an entry holds, scores are stored in 24 bits
+const int TT_SCORE_MAX = (1 << 23) - 1;
+
+// cache lines of counters, one per thread up to this many threads
+const size_t TT_STAT_STRIPES = 16;
+
+// what happens when two positions share a bucket
+enum class TTReplacement {
+    DEPTH_PREFERRED,
+    ALWAYS_REPLACE
+};
+
+// a single cached search result, as returned by a probe
+struct TTEntry {
+    uint64_t key;
+    int32_t score;
+    int16_t bestMove;       // square index (row * size + col), -1 if none
+    int8_t depth;           // remaining depth the score was searched to
+    TTBound bound;
+    uint8_t generation;     // which search stored the entry
+};
+
+// counters for tuning the table size, a snapshot when returned by getStats
+struct TTStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;          // the key was found
+    uint64_t misses = 0;        // the key wasn't found
+    uint64_t collisions = 0;    // misses where the bucket held a different position
+    uint64_t stores = 0;
+    uint64_t overwrites = 0;    // stores that evicted a different position
+    uint64_t rejected = 0;      // stores skipped because the stored entry was deeper
+};
+
+class TranspositionTable {
+private:
+    // one bucket, 16 bytes
+    struct TTSlot {
+        std::atomic<uint64_t> check;    // key ^ data
+        std::atomic<uint64_t> data;     // the packed entry
+    };
+
+    // the counters, in the order of TTStats
+    enum Counter {
+        PROBES,
+        HITS,
+        MISSES,
+        COLLISIONS,
+        STORES,
+        OVERWRITES,
+        REJECTED,
+        COUNTER_COUNT
+    };
+
+    // one thread's counters, a cache line of their own
+    struct alignas(64) StatStripe {
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+    };
+
+    std::unique_ptr<TTSlot[]> entries;
+    size_t bucketCount;
+    uint64_t indexMask;
+    TTReplacement policy;
+    std::atomic<uint8_t> generation;
+    mutable std::array<StatStripe, TT_STAT_STRIPES> stats;
+
+    // packs an entry's fields into one word
+    // score 24 bits, bestMove 16, then depth, bound and generation 8 each
+    static uint64_t pack(int score, int bestMove, int depth, TTBound bound, uint8_t entryGeneration) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(score)) & 0xFFFFFF) |
+               static_cast<uint64_t>(static_cast<uint16_t>(bestMove)) << 24 |
+               static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 40 |
+               static_cast<uint64_t>(bound) << 48 |
+               static_cast<uint64_t>(entryGeneration) << 56;
+    }
+
+    // unpacks a word written by pack
+    static TTEntry unpack(uint64_t key, uint64_t data) {
+        // sign extend the 24 bit score
+        int32_t score = static_cast<int32_t>(static_cast<uint32_t>(data << 8)) >> 8;
+        return TTEntry{
+            key,
+            score,
+            static_cast<int16_t>((data >> 24) & 0xFFFF),
+            static_cast<int8_t>((data >> 40) & 0xFF),
+            static_cast<TTBound>((data >> 48) & 0xFF),
+            static_cast<uint8_t>((data >> 56) & 0xFF)
+        };
+    }
+
+    // retrieves the stripe of the calling thread, the same for every table
+    static size_t statStripe() {
+        static std::atomic<size_t> nextStripe(0);
+        thread_local size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % TT_STAT_STRIPES;
+        return stripe;
+    }
+
+    // counts one event in the calling thread's stripe
+    void count(Counter counter) const {
+        std::atomic<uint64_t>& value = stats[statStripe()].counters[counter];
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+public:
+    // creates a table that uses at most the given number of megabytes
+    // the bucket count is rounded down to a power of two
+    //
+    // parameters:
+    // size_t megabytes - the memory budget (must be at least 1)
+    // TTReplacement replacement - the replacement policy
+    //
+    // throws:
+    // std::invalid_argument if the budget is 0
+    TranspositionTable(size_t megabytes, TTReplacement replacement = TTReplacement::DEPTH_PREFERRED)
+        : bucketCount(1), indexMask(0), policy(replacement), generation(0) {
+        if (megabytes == 0) {
+            throw std::invalid_argument("Transposition table needs at least 1 MB.");
+        }
+
+        // largest power of two that fits the budget
+        size_t budget = megabytes * 1024 * 1024 / sizeof(TTSlot);
+        while (bucketCount * 2 <= budget) {
+            bucketCount *= 2;
+        }
+
+        entries.reset(new TTSlot[bucketCount]);
+        indexMask = bucketCount - 1;
+        clear();
+    }
+
+    // marks the start of a new search, entries from older searches
+    // can be replaced regardless of depth
+    // must not be called while a search is running
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // void - does not return a value
+    void newSearch() {
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // looks up a position, safe to call from any thread
+    //
+    // parameters:
+    // uint64_t key - the position key
+    // TTEntry& entry - filled with the stored entry on a hit
+    //
+    // returns:
+    // bool - true if the position was found
+    bool probe(uint64_t key, TTEntry& entry) const {
+        count(PROBES);
+        const TTSlot& slot = entries[key & indexMask];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        TTEntry stored = unpack(check ^ data, data);
+
+        if (stored.bound != TTBound::NONE && stored.key == key) {
+            count(HITS);
+            entry = stored;
+            return true;
+        }
+
+        count(MISSES);
+        if (stored.bound != TTBound::NONE) {
+            count(COLLISIONS);
+        }
+        return false;
+    }
+
+    // stores a search result, subject to the replacement policy
+    // safe to call from any thread, when two threads store to the same
+    // bucket at once one of the results is kept
+    //
+    // parameters:
+    // uint64_t key - the position key
+    // int depth - the remaining depth the position was searched to
+    // int score - the score found
+    // TTBound bound - whether the score is exact or a bound
+    // int bestMove - square index of the best move, -1 if none
+    //
+    // returns:
+    // void - does not return a value
+    void store(uint64_t key, int depth, int score, TTBound bound, int bestMove) {
+        // a score too large to store still proves a bound on the side it's cut to,
+        // a bound pointing the other way proves nothing once cut and isn't stored
+        if (score > TT_SCORE_MAX) {
+            if (bound == TTBound::UPPER) {
+                return;
+            }
+            bound = TTBound::LOWER;
+            score = TT_SCORE_MAX;
+        } else if (score < -TT_SCORE_MAX) {
+            if (bound == TTBound::LOWER) {
+                return;
+            }
+            bound = TTBound::UPPER;
+            score = -TT_SCORE_MAX;
+        }
+
+        TTSlot& slot = entries[key & indexMask];
+        uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+        TTEntry old = unpack(slot.check.load(std::memory_order_relaxed) ^ oldData, oldData);
+        bool occupied = old.bound != TTBound::NONE;
+        uint8_t currentGeneration = generation.load(std::memory_order_relaxed);
+
+        if (occupied && policy == TTReplacement::DEPTH_PREFERRED &&
+            old.generation == currentGeneration && old.depth > depth) {
+            // keep the deeper result from this search
+            count(REJECTED);
+            return;
+        }
+
+        count(STORES);
+        if (occupied && old.key != key) {
+            count(OVERWRITES);
+        }
+
+        // keep the old best move if this search didn't find one
+        if (bestMove < 0 && occupied && old.key == key) {
+            bestMove = old.bestMove;
+        }
+
+        uint64_t data = pack(score, bestMove, depth, bound, currentGeneration);
+        slot.data.store(data, std::memory_order_relaxed);
+        slot.check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    // empties the table and resets the counters and the generation, so
+    // searches after a clear run as they would on a new table
+    // must not be called while a search is running
+    //
+    // parameters:
+    // none
+    //
+    // returns:
+    // void - does not return a value
+    void clear() {
+        uint64_t empty = pack(0, -1, 0, TTBound::NONE, 0);
+        for (size_t i = 0; i < bucketCount; ++i) {
+            entries[i].data.store(empty, std::memory_order_relaxed);
+            entries[i].check.store(empty, std::memory_order_relaxed);
+        }
+        for (StatStripe& stripe : stats) {
+            for (auto& counter : stripe.counters) {
+                counter.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation.store(0, std::memory_order_relaxed);
+    }
+
+    // retrieves the number of buckets
+    //
+    // returns:
+    // size_t - the bucket count (a power of two)
+    size_t size() const {
+        return bucketCount;
+    }
+
+    // retrieves the memory used by the buckets
+    //
+    // returns:
+    // size_t - bytes used
+    size_t memoryUsed() const {
+        return bucketCount * sizeof(TTSlot);
+    }
+
+    // retrieves the counters
+    //
+    // returns:
+    // TTStats - the counters since the table was created or cleared
+    TTStats getStats() const {
+        uint64_t totals[COUNTER_COUNT] = {};
+        for (const StatStripe& stripe : stats) {
+            for (int i = 0; i < COUNTER_COUNT; ++i) {
+                totals[i] += stripe.counters[i].load(std::memory_order_relaxed);
+            }
+        }
+        TTStats snapshot;
+        snapshot.probes = totals[PROBES];
+        snapshot.hits = totals[HITS];
+        snapshot.misses = totals[MISSES];
+        snapshot.collisions = totals[COLLISIONS];
+        snapshot.stores = totals[STORES];
+        snapshot.overwrites = totals[OVERWRITES];
+        snapshot.rejected = totals[REJECTED];
+        return snapshot;
+    }
+};
+
+#endif /* TRANSPOSITIONTABLE_H */
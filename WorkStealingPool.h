@@ -0,0 +1,195 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: Work Stealing Pool
+ *
+ * A fixed set of threads running tasks. Each worker has its own queue,
+ * tasks submitted from outside the pool are dealt round robin across the
+ * queues and a task submitted by a worker goes on that worker's queue. A
+ * worker takes the oldest task of its own queue first, so requests are
+ * served roughly in order, and once it runs dry it steals the newest task
+ * from another worker's queue. Searches take very different times (a
+ * book hit is instant, a midgame search at depth 8 is not), stealing
+ * keeps every core busy until the last one is done.
+ *
+ * The queues are plain deques behind a mutex each, a worker only touches
+ * another worker's lock when it steals. Idle workers sleep on one
+ * condition variable.
+ *
+ */
+
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    // tasks queued and not yet taken
+    std::atomic<size_t> queued;
+    // the queue the next outside task goes on
+    std::atomic<size_t> nextQueue;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    // the pool and worker index of the calling thread, nullptr outside any pool
+    static const WorkStealingPool*& currentPool() {
+        static thread_local const WorkStealingPool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& currentWorker() {
+        static thread_local size_t worker = 0;
+        return worker;
+    }
+
+    // takes the oldest task of the worker's own queue or steals the newest of another
+    //
+    // parameters:
+    // size_t worker - the worker looking for work
+    // Task& task - set to the task taken
+    //
+    // returns:
+    // bool - false if every queue is empty
+    bool take(size_t worker, Task& task) {
+        for (size_t i = 0; i < queues.size(); ++i) {
+            Queue& queue = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            } else {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void work(size_t worker) {
+        currentPool() = this;
+        currentWorker() = worker;
+        Task task;
+        while (true) {
+            if (take(worker, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this]() { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    // puts a task on a queue without waking anyone
+    void enqueue(Task task) {
+        size_t target;
+        if (currentPool() == this) {
+            target = currentWorker();
+        } else {
+            target = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues[target]->mutex);
+            queues[target]->tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+
+public:
+    // starts the workers
+    //
+    // parameters:
+    // int threadCount - the number of workers, at least 1 is started
+    explicit WorkStealingPool(int threadCount) : queued(0), nextQueue(0), stopping(false) {
+        size_t count = static_cast<size_t>(std::max(threadCount, 1));
+        for (size_t i = 0; i < count; ++i) {
+            queues.emplace_back(new Queue());
+        }
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    // stops the workers once their current tasks are done, tasks still queued are dropped
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // queues a task
+    //
+    // parameters:
+    // Task task - the work, it runs on one of the workers
+    //
+    // returns:
+    // void - does not return a value
+    void submit(Task task) {
+        enqueue(std::move(task));
+        // taking the lock orders the push before a sleeping worker's check
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wakeUp.notify_one();
+    }
+
+    // queues many tasks, spread over the queues, and wakes the workers once
+    //
+    // parameters:
+    // std::vector<Task>& tasks - the work, moved from
+    //
+    // returns:
+    // void - does not return a value
+    void submit(std::vector<Task>& tasks) {
+        for (auto& task : tasks) {
+            enqueue(std::move(task));
+        }
+        tasks.clear();
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wakeUp.notify_all();
+    }
+
+    // the number of workers
+    int size() const {
+        return static_cast<int>(threads.size());
+    }
+};
+
+#endif /* WORKSTEALINGPOOL_H */
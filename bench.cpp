@@ -0,0 +1,622 @@
+/***********************************************************************************
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda (rkaganda@gmail.com)
+ *
+ * Description:
+ * - Performance regression suite, built and run with `make bench`,
+ *   separate from the game build.
+ * - Perft: counts the leaves of the move tree from the 8x8 start position
+ *   with getValidMoves + placePiece/undoMove and checks them against the
+ *   published values, for every backend and FixedBoard<8>, and from the
+ *   10x10 start position for the flat board against FixedBoard<10>.
+ * - Microbenchmarks for hashBoard, findFlippablePieces and Board copy.
+ * - The root move containers: RootMoveList against the AVLTree it replaced,
+ *   filling one, picking the best and a random move, and a depth 1 search.
+ * - getAIMove timings at depths 1-6 for board sizes 8, 10 and 16.
+ * - A batch of AI turns from games sharing their openings, one getAIMove
+ *   after another against getAIMoves on every core with a shared table.
+ * - Every timing is printed next to the map backend's so a change can be
+ *   compared against the original Board in one run. The backend columns
+ *   search the Board itself, the fixed column the FixedBoard copy getAIMove
+ *   makes (unless --no-fixed-boards), next to the backend it would otherwise use.
+ *
+ * Options:
+ *   --perft-depth N   deepest perft depth to check (default 8, max 10)
+ *   --max-depth N     deepest getAIMove depth to time (default 6)
+ *   --min-ms N        minimum time per microbenchmark in ms (default 200)
+ *
+ ***********************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+// include board implementation
+#include "Board.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include the AI search
+#include "Search.h"
+// include fixed size board implementation
+#include "FixedBoard.h"
+// include avltree implementation
+#include "AVLTree.h"
+// include root move list implementation
+#include "RootMoves.h"
+// include batched search implementation
+#include "BatchSearch.h"
+
+
+// leaf counts from the 8x8 start position, a pass counts as a ply and a
+// finished game is a leaf
+const uint64_t PERFT_8X8[] = {
+    1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284
+};
+const int PERFT_MAX_DEPTH = 10;
+
+// keeps the compiler from throwing away a benchmark's result
+volatile uint64_t benchSink = 0;
+
+
+// settings from the command line
+struct BenchOptions {
+    int perftDepth = 8;
+    int maxDepth = 6;
+    int minMs = 200;
+};
+
+
+// returns the name of a backend for the report
+//
+// parameters:
+// BoardBackend backend - the backend
+//
+// returns:
+// std::string - its name
+
+std::string backendName(BoardBackend backend) {
+    switch (backend) {
+        case BoardBackend::MAP: return "map";
+        case BoardBackend::FLAT: return "flat";
+        case BoardBackend::BITBOARD: return "bitboard";
+    }
+    return "unknown";
+}
+
+
+// the backends that can hold a board of the given size, map first
+//
+// parameters:
+// int size - the board size
+//
+// returns:
+// std::vector<BoardBackend> - the backends to compare
+
+std::vector<BoardBackend> backendsFor(int size) {
+    std::vector<BoardBackend> backends = {BoardBackend::MAP, BoardBackend::FLAT};
+    if (size <= BITBOARD_STRIDE) {
+        backends.push_back(BoardBackend::BITBOARD);
+    }
+    return backends;
+}
+
+
+// milliseconds since a start time
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+// runs a function repeatedly until at least minMs has passed
+//
+// parameters:
+// int minMs - the minimum total time
+// Function run - the work to time, called with no arguments
+//
+// returns:
+// double - nanoseconds per call
+
+template <typename Function>
+double timePerCall(int minMs, Function run) {
+    uint64_t calls = 0;
+    uint64_t batch = 1;
+    auto start = std::chrono::steady_clock::now();
+    double ms = 0.0;
+    while (ms < minMs) {
+        for (uint64_t i = 0; i < batch; ++i) {
+            run();
+        }
+        calls += batch;
+        batch *= 2;
+        ms = elapsedMs(start);
+    }
+    return ms * 1e6 / calls;
+}
+
+
+// counts the leaves of the move tree to the given depth
+//
+// parameters:
+// BoardType& board - the position, restored before returning
+// int player - the player to move
+// int depth - plies left
+//
+// returns:
+// uint64_t - the number of leaves
+
+template <typename BoardType>
+uint64_t perft(BoardType& board, int player, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    int opponent = (player == 1) ? 2 : 1;
+    MoveList validMoves = board.getValidMoves(player);
+
+    if (validMoves.empty()) {
+        // the game is over, or the player passes
+        if (board.getValidMoves(opponent).empty()) {
+            return 1;
+        }
+        return perft(board, opponent, depth - 1);
+    }
+
+    // the last ply only needs the count
+    if (depth == 1) {
+        return validMoves.size();
+    }
+
+    uint64_t leaves = 0;
+    for (const auto& move : validMoves) {
+        board.placePiece(move, player);
+        leaves += perft(board, opponent, depth - 1);
+        board.undoMove(move, player);
+    }
+    return leaves;
+}
+
+
+// plays moves picked by a fixed pseudo-random sequence to reach a midgame
+// position, every backend reaches the same one
+//
+// parameters:
+// Board& board - an empty starting board
+// int plies - moves to play
+// uint64_t seed - picks the sequence, each seed reaches its own position
+//
+// returns:
+// int - the player to move afterwards
+
+int playOpening(Board& board, int plies, uint64_t seed = 1) {
+    int player = 1;
+    uint64_t state = seed;
+    for (int i = 0; i < plies; ++i) {
+        MoveList validMoves = board.getValidMoves(player);
+        if (validMoves.empty()) {
+            player = (player == 1) ? 2 : 1;
+            continue;
+        }
+        state = splitMix64(state);
+        board.placePiece(validMoves[state % validMoves.size()], player);
+        player = (player == 1) ? 2 : 1;
+    }
+    return player;
+}
+
+
+// checks perft for every backend and FixedBoard<8>, and the flat board
+// against FixedBoard<10>, and prints the time each takes
+//
+// parameters:
+// const BenchOptions& options - the deepest depth to check
+//
+// returns:
+// bool - true if every count matched
+
+bool runPerft(const BenchOptions& options) {
+    std::cout << "perft 8x8 (leaves, ms per backend)\n";
+    std::cout << std::left << std::setw(7) << "depth" << std::setw(12) << "leaves";
+    for (BoardBackend backend : backendsFor(8)) {
+        std::cout << std::setw(12) << backendName(backend);
+    }
+    std::cout << std::setw(12) << "fixed" << "\n";
+
+    bool passed = true;
+    for (int depth = 1; depth <= options.perftDepth; ++depth) {
+        std::cout << std::setw(7) << depth << std::setw(12) << PERFT_8X8[depth];
+        for (BoardBackend backend : backendsFor(8)) {
+            Board board(8, backend);
+            auto start = std::chrono::steady_clock::now();
+            uint64_t leaves = perft(board, 1, depth);
+            double ms = elapsedMs(start);
+            if (leaves != PERFT_8X8[depth]) {
+                std::cout << "FAIL " << leaves << " ";
+                passed = false;
+            }
+            std::cout << std::setw(12) << std::fixed << std::setprecision(1) << ms;
+        }
+
+        FixedBoard<8> fixedBoard;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t leaves = perft(fixedBoard, 1, depth);
+        double ms = elapsedMs(start);
+        if (leaves != PERFT_8X8[depth]) {
+            std::cout << "FAIL " << leaves << " ";
+            passed = false;
+        }
+        std::cout << std::setw(12) << std::fixed << std::setprecision(1) << ms << "\n";
+    }
+    std::cout << "\n";
+
+    // no published values past 8x8, the flat board and FixedBoard<10> have to agree
+    std::cout << "perft 10x10 (leaves, ms), flat against fixed\n";
+    std::cout << std::setw(7) << "depth" << std::setw(12) << "leaves" << std::setw(12) << "flat"
+              << std::setw(12) << "fixed" << "\n";
+    for (int depth = 1; depth <= options.perftDepth; ++depth) {
+        Board board(10, BoardBackend::FLAT);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t leaves = perft(board, 1, depth);
+        double flatMs = elapsedMs(start);
+
+        FixedBoard<10> fixedBoard;
+        start = std::chrono::steady_clock::now();
+        uint64_t fixedLeaves = perft(fixedBoard, 1, depth);
+        double fixedMs = elapsedMs(start);
+
+        std::cout << std::setw(7) << depth << std::setw(12) << leaves;
+        if (fixedLeaves != leaves) {
+            std::cout << "FAIL " << fixedLeaves << " ";
+            passed = false;
+        }
+        std::cout << std::setw(12) << std::fixed << std::setprecision(1) << flatMs
+                  << std::setw(12) << fixedMs << "\n";
+    }
+    std::cout << "\n";
+    return passed;
+}
+
+
+// times hashBoard, findFlippablePieces over every empty square and
+// direction, and Board copy on a midgame position for every backend
+//
+// parameters:
+// const BenchOptions& options - the minimum time per benchmark
+//
+// returns:
+// void - does not return a value
+
+void runMicrobenchmarks(const BenchOptions& options) {
+    std::cout << "microbenchmarks (ns per call, speedup vs map)\n";
+    std::cout << std::left << std::setw(6) << "size" << std::setw(10) << "backend"
+              << std::setw(20) << "hashBoard" << std::setw(20) << "findFlippable"
+              << std::setw(20) << "copy" << "\n";
+
+    for (int size : {8, 16}) {
+        double mapTimes[3] = {0, 0, 0};
+        for (BoardBackend backend : backendsFor(size)) {
+            Board board(size, backend);
+            int player = playOpening(board, size * size / 3);
+
+            // the empty squares, checked in every direction
+            std::vector<std::pair<int, int>> emptySquares;
+            for (int row = 0; row < size; ++row) {
+                for (int col = 0; col < size; ++col) {
+                    if (board.getBoardPlaceValue({row, col}) == 0) {
+                        emptySquares.push_back({row, col});
+                    }
+                }
+            }
+
+            double times[3];
+            times[0] = timePerCall(options.minMs, [&]() {
+                benchSink += board.hashBoard();
+            });
+            times[1] = timePerCall(options.minMs, [&]() {
+                int flips = 0;
+                for (const auto& square : emptySquares) {
+                    for (const auto& direction : directions) {
+                        flips += board.findFlippablePieces(square, player, direction);
+                    }
+                }
+                benchSink += flips;
+            });
+            times[2] = timePerCall(options.minMs, [&]() {
+                Board copy = board;
+                benchSink += copy.getHash();
+            });
+
+            std::cout << std::setw(6) << size << std::setw(10) << backendName(backend);
+            for (int i = 0; i < 3; ++i) {
+                if (backend == BoardBackend::MAP) {
+                    mapTimes[i] = times[i];
+                }
+                std::string cell = std::to_string(static_cast<long long>(times[i] + 0.5));
+                if (backend != BoardBackend::MAP) {
+                    char speedup[32];
+                    std::snprintf(speedup, sizeof(speedup), " (%.1fx)", mapTimes[i] / times[i]);
+                    cell += speedup;
+                }
+                std::cout << std::setw(20) << cell;
+            }
+            std::cout << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+
+// times the root move containers, RootMoveList against AVLTree
+//
+// parameters:
+// const BenchOptions& options - the minimum time per measurement
+//
+// returns:
+// void - does not return a value
+
+void runRootMoveBenchmarks(const BenchOptions& options) {
+    typedef std::pair<int, std::pair<int, int>> ScoredMove;
+    std::cout << "root moves (ns per fill + best + random), speedup vs avl\n";
+    std::cout << std::left << std::setw(8) << "moves" << std::setw(14) << "avl" << "list\n";
+
+    AVLNodePool<ScoredMove> pool;
+    for (int count : {8, 16, 32}) {
+        // the same scores every run, spread out like search scores
+        std::vector<ScoredMove> scored;
+        uint64_t state = 1;
+        for (int i = 0; i < count; ++i) {
+            state = splitMix64(state);
+            scored.push_back({static_cast<int>(state % 200) - 100, {i / 8, i % 8}});
+        }
+
+        double avlNs = timePerCall(options.minMs, [&]() {
+            pool.reset();
+            AVLTree<ScoredMove> tree(&pool);
+            for (const auto& move : scored) {
+                tree.insert(move);
+            }
+            std::pair<int, int> best = findBestMove(tree.get_root());
+            std::pair<int, int> random = getRandomMove(tree.get_root());
+            benchSink += best.first + random.second;
+        });
+        double listNs = timePerCall(options.minMs, [&]() {
+            RootMoveList list;
+            for (const auto& move : scored) {
+                list.insert(move);
+            }
+            std::pair<int, int> best = findBestMove(list);
+            std::pair<int, int> random = getRandomMove(list);
+            benchSink += best.first + random.second;
+        });
+        char speedup[32];
+        std::snprintf(speedup, sizeof(speedup), " (%.1fx)", avlNs / listNs);
+        std::cout << std::setw(8) << count << std::setw(14) << static_cast<uint64_t>(avlNs)
+                  << static_cast<uint64_t>(listNs) << speedup << "\n";
+    }
+
+    // a whole depth 1 search on a FixedBoard<8>, where the container is the largest share
+    Board board(8);
+    int player = playOpening(board, 16);
+    FixedBoard<8> fixedBoard(board);
+    MoveList validMoves = fixedBoard.getValidMoves(player);
+    TranspositionTable table(16);
+    SearchOptions search;
+    search.maxDepth = 1;
+    double avlNs = timePerCall(options.minMs, [&]() {
+        pool.reset();
+        AVLTree<ScoredMove> tree(&pool);
+        populateMoveTreeWithOptions(tree, validMoves, fixedBoard, player, table, search, nullptr);
+        benchSink += findBestMove(tree.get_root()).first;
+    });
+    double listNs = timePerCall(options.minMs, [&]() {
+        RootMoveList list;
+        populateMoveTreeWithOptions(list, validMoves, fixedBoard, player, table, search, nullptr);
+        benchSink += findBestMove(list).first;
+    });
+    char speedup[32];
+    std::snprintf(speedup, sizeof(speedup), " (%.1fx)", avlNs / listNs);
+    std::cout << std::setw(8) << "depth 1" << std::setw(14) << static_cast<uint64_t>(avlNs)
+              << static_cast<uint64_t>(listNs) << speedup << "  (" << validMoves.size() << " moves)\n\n";
+}
+
+
+// times getAIMove from a midgame position at every depth and board size
+// each call starts with an empty transposition table
+//
+// parameters:
+// const BenchOptions& options - the deepest depth to time
+//
+// returns:
+// void - does not return a value
+
+void runSearchBenchmarks(const BenchOptions& options) {
+    std::cout << "getAIMove alpha-beta (ms, nodes), speedup vs map\n";
+    std::cout << std::left << std::setw(6) << "size" << std::setw(7) << "depth" << std::setw(12) << "nodes";
+    std::cout << std::setw(18) << "map" << std::setw(18) << "flat" << std::setw(18) << "bitboard"
+              << std::setw(18) << "fixed" << "\n";
+
+    TranspositionTable table(64);
+    for (int size : {8, 10, 16}) {
+        for (int depth = 1; depth <= options.maxDepth; ++depth) {
+            SearchOptions search;
+            search.maxDepth = depth;
+
+            // times one search from the same midgame position
+            auto timeSearch = [&](BoardBackend backend, bool fixedBoards, SearchInfo& info) {
+                Board board(size, backend);
+                int player = playOpening(board, size * size / 4);
+                MoveList validMoves = board.getValidMoves(player);
+
+                search.fixedBoards = fixedBoards;
+                table.clear();
+                auto start = std::chrono::steady_clock::now();
+                std::pair<int, int> move = getAIMove(validMoves, board, player, table, search, &info);
+                double ms = elapsedMs(start);
+                benchSink += move.first + move.second;
+                return ms;
+            };
+
+            // formats a time with its speedup over the map backend
+            double mapMs = 0.0;
+            auto cell = [&](double ms) {
+                std::string text = std::to_string(ms);
+                text = text.substr(0, text.find('.') + 3);
+                char speedup[32];
+                std::snprintf(speedup, sizeof(speedup), " (%.1fx)", mapMs / ms);
+                return text + speedup;
+            };
+
+            std::cout << std::setw(6) << size << std::setw(7) << depth;
+            bool first = true;
+            for (BoardBackend backend : backendsFor(size)) {
+                // the backend columns search the Board itself
+                SearchInfo info;
+                double ms = timeSearch(backend, false, info);
+                if (first) {
+                    std::cout << std::setw(12) << info.nodes;
+                    first = false;
+                }
+                if (backend == BoardBackend::MAP) {
+                    mapMs = ms;
+                    std::string text = std::to_string(ms);
+                    std::cout << std::setw(18) << text.substr(0, text.find('.') + 3);
+                } else {
+                    std::cout << std::setw(18) << cell(ms);
+                }
+            }
+            if (size > BITBOARD_STRIDE) {
+                std::cout << std::setw(18) << "-";
+            }
+
+            // a FixedBoard copy when the size has one, what getAIMove searches by default
+            SearchInfo info;
+            std::string fixedCell = "-";
+            if (size == 6 || size == 8 || size == 10 || size == 12) {
+                fixedCell = cell(timeSearch(Board::defaultBackend(size), true, info));
+            }
+            std::cout << std::setw(18) << fixedCell << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+
+// times a batch of AI turns, one getAIMove after another on one thread
+// against getAIMoves on a pool of every core, both start with an empty table
+// the games come in groups of 4 that share an opening
+//
+// parameters:
+// const BenchOptions& options - the deepest depth to time
+//
+// returns:
+// void - does not return a value
+
+void runBatchBenchmarks(const BenchOptions& options) {
+    int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "getAIMoves, 64 turns in 16 openings on 8x8 (ms), " << workers << " workers, speedup vs one by one\n";
+    std::cout << std::left << std::setw(7) << "depth" << std::setw(14) << "one by one" << "batch\n";
+
+    std::vector<AIMoveRequest> requests;
+    for (int i = 0; i < 64; ++i) {
+        Board board(8);
+        int player = playOpening(board, 10, i % 16 + 1);
+        requests.push_back(AIMoveRequest{static_cast<uint64_t>(i), board, player});
+    }
+
+    WorkStealingPool pool(workers);
+    TranspositionTable table(64);
+    for (int depth = 2; depth <= options.maxDepth; depth += 2) {
+        SearchOptions search;
+        search.maxDepth = depth;
+        search.endgameEmpties = 0;
+
+        // every game on its own, aging the table for each move like a single game does
+        table.clear();
+        auto start = std::chrono::steady_clock::now();
+        for (AIMoveRequest request : requests) {
+            MoveList validMoves = request.board.getValidMoves(request.player);
+            benchSink += getAIMove(validMoves, request.board, request.player, table, search).first;
+        }
+        double singleMs = elapsedMs(start);
+
+        table.clear();
+        start = std::chrono::steady_clock::now();
+        for (const AIMoveResult& result : getAIMoves(requests, pool, table, search)) {
+            benchSink += result.move.first;
+        }
+        double batchMs = elapsedMs(start);
+
+        std::string text = std::to_string(singleMs);
+        char batch[64];
+        std::snprintf(batch, sizeof(batch), "%.2f (%.1fx)", batchMs, singleMs / batchMs);
+        std::cout << std::setw(7) << depth << std::setw(14) << text.substr(0, text.find('.') + 3) << batch << "\n";
+    }
+    std::cout << "\n";
+}
+
+
+// parses the command line options
+//
+// parameters:
+// int argc - the number of arguments
+// char* argv[] - the arguments
+//
+// returns:
+// BenchOptions - the parsed options
+//
+// throws:
+// std::invalid_argument if an option is unknown or its value is invalid
+
+BenchOptions parseBenchOptions(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Unknown option or missing value: " + arg);
+        }
+        int value = std::atoi(argv[++i]);
+        if (arg == "--perft-depth" && value >= 1 && value <= PERFT_MAX_DEPTH) {
+            options.perftDepth = value;
+        } else if (arg == "--max-depth" && value >= 1) {
+            options.maxDepth = value;
+        } else if (arg == "--min-ms" && value >= 1) {
+            options.minMs = value;
+        } else {
+            throw std::invalid_argument("Invalid option: " + arg + " " + argv[i]);
+        }
+    }
+    return options;
+}
+
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        options = parseBenchOptions(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << "\n";
+        std::cerr << "Usage: othello_bench [--perft-depth N] [--max-depth N] [--min-ms N]\n";
+        return 1;
+    }
+
+    // the search picks a random move half the time, keep runs comparable
+    setRandomSeed(1);
+
+    bool passed = runPerft(options);
+    runMicrobenchmarks(options);
+    runRootMoveBenchmarks(options);
+    runSearchBenchmarks(options);
+    runBatchBenchmarks(options);
+
+    if (!passed) {
+        std::cout << "perft FAILED\n";
+        return 1;
+    }
+    std::cout << "perft passed\n";
+    return 0;
+}
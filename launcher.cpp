@@ -0,0 +1,171 @@
+/*
+ * Over-Engineered Othello Redux
+ *
+ * Author: Rukundo Kaganda
+ *
+ * Note: CPU Dispatching Launcher
+ *
+ * `make optimized` builds the game once per CPU level (see the Makefile):
+ * a generic x86-64 binary that runs anywhere and an x86-64-v3 one built
+ * for CPUs with AVX2, BMI, FMA, F16C, LZCNT, MOVBE and XSAVE (and the
+ * SSE4.2 and popcnt of x86-64-v2 before it). This launcher is installed
+ * next to them as `othello`, checks which level the CPU has and runs the
+ * best binary with the same arguments, so a popcount in the bitboard
+ * move generator is one instruction where the CPU has it.
+ *
+ * OTHELLO_ARCH=x86-64 (or x86-64-v3) picks a binary by hand, for
+ * comparing the builds on one machine.
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+
+// the binaries, best first, each is named othello-<level>
+const char* const LAUNCHER_LEVELS[] = {"x86-64-v3", "x86-64"};
+const int LAUNCHER_LEVEL_COUNT = 2;
+
+
+// checks if the CPU can run a binary built for a level
+//
+// parameters:
+// const std::string& level - the level, e.g. x86-64-v3
+//
+// returns:
+// bool - true if every instruction of the level is there
+bool cpuSupports(const std::string& level) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (level == "x86-64-v3") {
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+        // gcc knows the levels itself, the same list -march=x86-64-v3 builds for
+        return __builtin_cpu_supports("x86-64-v3");
+#else
+        // the v3 level spelled out, the v2 features it includes and the ones
+        // __builtin_cpu_supports has no name for read from cpuid
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        // cmpxchg16b, xsave and f16c
+        const unsigned int leaf1 = (1u << 13) | (1u << 26) | (1u << 29);
+        if ((ecx & leaf1) != leaf1 || !__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        // lahf/sahf and lzcnt
+        const unsigned int extended = (1u << 0) | (1u << 5);
+        return (ecx & extended) == extended &&
+               __builtin_cpu_supports("sse3") && __builtin_cpu_supports("ssse3") &&
+               __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("sse4.2") &&
+               __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("avx") &&
+               __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+               __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("fma") &&
+               __builtin_cpu_supports("movbe");
+#endif
+    }
+    return level == "x86-64";
+#else
+    return false;
+#endif
+}
+
+// retrieves the directory the launcher is in, the binaries are next to it
+//
+// parameters:
+// const char* argv0 - the path the launcher was started with
+//
+// returns:
+// std::string - the directory with a trailing separator, empty for the current one
+std::string launcherDirectory(const char* argv0) {
+    std::string path;
+#ifdef _WIN32
+    char buffer[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+    if (length > 0 && length < MAX_PATH) {
+        path.assign(buffer, length);
+    }
+#else
+    char buffer[4096];
+    ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (length > 0) {
+        path.assign(buffer, static_cast<size_t>(length));
+    }
+#endif
+    if (path.empty() && argv0) {
+        path = argv0;
+    }
+    size_t separator = path.find_last_of("/\\");
+    return (separator == std::string::npos) ? std::string() : path.substr(0, separator + 1);
+}
+
+// runs a binary in place of the launcher with the launcher's arguments
+//
+// parameters:
+// const std::string& binary - the path of the binary
+// char* argv[] - the launcher's arguments
+//
+// returns:
+// int - the binary's exit code on Windows, on other systems only returns if the binary couldn't be started
+int runBinary(const std::string& binary, char* argv[]) {
+    std::vector<char*> arguments;
+    arguments.push_back(const_cast<char*>(binary.c_str()));
+    for (int i = 1; argv[i]; ++i) {
+        arguments.push_back(argv[i]);
+    }
+    arguments.push_back(nullptr);
+#ifdef _WIN32
+    // windows has no exec that keeps the console, wait for the game instead
+    intptr_t code = _spawnv(_P_WAIT, binary.c_str(), arguments.data());
+    return static_cast<int>(code);
+#else
+    execv(binary.c_str(), arguments.data());
+    return -1;
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    std::string directory = launcherDirectory(argv[0]);
+    const char* forced = std::getenv("OTHELLO_ARCH");
+
+    for (int i = 0; i < LAUNCHER_LEVEL_COUNT; ++i) {
+        std::string level = LAUNCHER_LEVELS[i];
+        if (forced ? level != forced : !cpuSupports(level)) {
+            continue;
+        }
+        std::string binary = directory + "othello-" + level;
+#ifdef _WIN32
+        binary += ".exe";
+#endif
+        int code = runBinary(binary, argv);
+        if (code >= 0) {
+            return code;
+        }
+        // not built or not runnable, try the next level down
+        std::fprintf(stderr, "othello: can't run %s: %s\n", binary.c_str(), std::strerror(errno));
+        if (forced) {
+            return 1;
+        }
+    }
+
+    std::fprintf(stderr, "othello: no binary in %s runs on this CPU%s%s\n",
+                 directory.empty() ? "." : directory.c_str(), forced ? " for OTHELLO_ARCH=" : "",
+                 forced ? forced : "");
+    return 1;
+}
@@ -26,438 +26,52 @@
 #include <ctime>
 #include <queue>
 #include <string>
-#include <unordered_map>
-
-// include avttree implementation
-#include "AVLTree.h"
-
-
-// list of directions used to check for flippable pieces around a position on the board
-// each pair represents a direction (e.g., {-1, 0} is north, {1, 1} is southeast)
-// used to check for anchor points
-const std::list<std::pair<int, int>> directions = {
-    {-1, 0},  // north
-    {1, 0},   // south
-    {0, -1},  // west
-    {0, 1},   // east
-    {-1, -1}, // northwest
-    {-1, 1},  // northeast
-    {1, -1},  // southwest
-    {1, 1}    // southeast
-};
-
-// struct to store player moves, 
-// used in the game history stack
-struct PlayerMove {
-    int thePlayer;
-    std::pair<int,int> theLocation;
-    
-    PlayerMove(int player, std::pair<int,int> location) {
-        thePlayer = player;
-        theLocation = location;
-    }
-};
-
-// class representing a single square on the board
-// which can be empty or occupied by a player
-class BoardSquare {
-private:
-    // 0 for empty
-    // 1 for player X
-    // 2 for player 0
-    int value; 
-
-public:
-    // constructor to initialize a square as empty
-    BoardSquare() {
-        value = 0;
-    }
-    
-
-    // sets a piece for the specified player, throws an error if the square is already occupied
-    //
-    // parameters:
-    // int player - the player placing a piece (1 for 'X', 2 for 'O')
-    //
-    // throws:
-    // std::runtime_error if the square is already occupied
-    void setPiece(int player) {
-        if (value != 0) {
-            throw std::runtime_error("square is already occupied.");
-        }
-        value = player;
-    }
-
-    // flips the piece on the square (from 'X' to 'O' or vice versa),
-    // throws an error if the square is empty
-    //
-    // throws:
-    // std::runtime_error if the square is empty
-    void flipPiece() {
-        if (value == 0) {
-            throw std::runtime_error("cannot flip an empty square.");
-        }
-        value = (value == 1) ? 2 : 1; // flip between 1 and 2
-    }
-
-    // retrieves the value of the square
-    //
-    // returns:
-    // int - the value of the square (0 for empty, 1 for 'X', 2 for 'O')
-    int getValue() const {
-        return value;
-    }
-
-    // checks if the square is empty
-    //
-    // returns:
-    // bool - true if the square is empty, false otherwise
-    bool isEmpty() const {
-        return value == 0;
-    }
-};
-
-class Board {
-private:
-    // map holds the BoardSquares
-    std::map<std::pair<int, int>, BoardSquare> board;
-    int maxBoardSize;
-
-public:
-    // initializes the board with a given size
-    // sets up an empty board, ensuring the size is at least 4x4, and places starting pieces at the center
-    //
-    // parameters:
-    // int size - the size of the board (must be at least 4)
-    //
-    // throws:
-    // std::invalid_argument if the board size is less than 4
-    Board(int size) : maxBoardSize(size) {
-        // check for invalid board
-        if (size < 4) {
-            throw std::invalid_argument("Board size must be at least 4.");
-        }
-
-        // init an empty board
-        for (int row = 0; row < maxBoardSize; ++row) {
-            for (int col = 0; col < maxBoardSize; ++col) {
-                board[{row, col}] = BoardSquare();
-            }
-        }
-
-        // find center to place starting pieces
-        int center = maxBoardSize / 2;
-
-        // set up starting pieces:
-        // 0 1
-        // 1 0
-        try {
-            board.at({center - 1, center - 1}).setPiece(1);  // Top-left of center with Player X (1)
-            board.at({center - 1, center}).setPiece(2);      // Top-right of center with Player O (2)
-            board.at({center, center - 1}).setPiece(2);      // Bottom-left of center with Player O (2)
-            board.at({center, center}).setPiece(1);          // Bottom-right of center with Player X (1)
-        } catch (const std::exception& e) {
-            std::cerr << "Error initializing the board's center pieces: " << e.what() << std::endl;
-        }
-    }
-    
-    // TODO 
-    std::string hashBoard() const {
-        std::string boardHash;
-        for (int row = 0; row < maxBoardSize; ++row) {
-            for (int col = 0; col < maxBoardSize; ++col) {
-                boardHash += std::to_string(getBoardPlaceValue({row, col})) + ",";
-            }
-        }
-        return boardHash;
-    }
-
-    // places a piece on the board at the specified location for a given player
-    // flips the pieces in the set of positions provided
-    //
-    // parameters:
-    // const std::pair<int, int>& position - the position to place the piece
-    // int player - the player number (1 for 'X', 2 for 'O')
-    // const std::set<std::pair<int, int>>& toFlip - the set of positions to flip after placing the piece
-    //
-    // returns:
-    // void - does not return a value
-    void placePiece(
-        const std::pair<int, int>& position, 
-        int player, 
-        const std::set<std::pair<int, int>>& toFlip
-    ) {
-        // set the value to 1 or 2 based on the player
-        board.at(position).setPiece(player); 
-        
-        // flip each piece in the list
-        std::for_each(toFlip.begin(), toFlip.end(), [this](const auto& flipPosition) {
-            board.at(flipPosition).flipPiece();
-        });
-    }
-    
-    // retrieves the value at a specified board position
-    //
-    // parameters:
-    // const std::pair<int, int>& position - the position on the board
-    //
-    // returns:
-    // int - the value at the specified position (0 for empty, 1 for 'X', 2 for 'O')
-    int getBoardPlaceValue(const std::pair<int, int>& position) const {
-        return board.at(position).getValue();
-    }
-    
-    // checks if there are pieces to flip in a given direction for a move by the specified player
-    // if there are, populates 'toFlip' with the locations of those pieces
-    //
-    // parameters:
-    // std::pair<int, int> position - the starting position for checking flips
-    // int player - the player number (1 for 'X', 2 for 'O')
-    // std::pair<int, int> direction - the direction to check for flippable pieces
-    // std::set<std::pair<int, int>>& toFlip - a set to populate with flippable positions
-    //
-    // returns:
-    // bool - true if there are pieces to flip, false otherwise
-    bool findFlippablePieces(
-        std::pair<int, int> position,
-        int player,
-        std::pair<int, int> direction,
-        std::set<std::pair<int, int>>& toFlip
-    ) const {
-        bool piecesToFlip = false;
-        // clear the flip list
-        toFlip.clear();
-        
-        // get value of opponent
-        int opponent = (player == 1) ? 2 : 1;
-
-        // move to the next position in the specified direction
-        position.first += direction.first;
-        position.second += direction.second;
-
-        // traverse the board in that direction
-        // until we reach the end of the board
-        while (position.first >= 0 && position.first < maxBoardSize &&
-               position.second >= 0 && position.second < maxBoardSize) {
-
-            int value = board.at({position.first, position.second}).getValue();
-
-            if (value == opponent) {
-                // add opponent's piece to the flip path
-                toFlip.insert(position);
-            } else if (value == player) {
-                // found an anchor piece of the same color
-                // return the negation of toFlip 
-                // so if there are pieces to flip this returns true
-                piecesToFlip = !toFlip.empty(); // Only valid if there are pieces to flip
-                break;
-            } else {
-                // Empty square encountered, no anchor in this direction
-                break;
-            }
-
-            // Move to the next position in the specified direction
-            position.first += direction.first;
-            position.second += direction.second;
-        }
-
-        // No anchor piece found in this direction
-        if (!piecesToFlip) {
-            toFlip.clear();   
-        }
-        return piecesToFlip;
-    }
-    
-    // generates all valid moves for a given player based on Othello rules
-    // stores each valid move and its corresponding flippable pieces in a map
-    //
-    // parameters:
-    // int player - the player number (1 for 'X', 2 for 'O')
-    //
-    // returns:
-    // std::map<std::pair<int, int>, std::set<std::pair<int, int>>> - a map of valid moves
-    // where each key is a board position and the associated value is a set of positions that would be flipped
-    std::map<std::pair<int, int>, std::set<std::pair<int, int>>> getValidMoves(int player) const {
-        // map to store valid moves and flippable pieces
-        std::map<std::pair<int, int>, std::set<std::pair<int, int>>> validMovesMap;  
-        
-        // lambda empty check for find_if
-        auto isSquareEmpty = [this](const auto& entry) {
-            return entry.second.isEmpty();
-        };
-        
-        // get iterator for the start of the board
-        auto it = board.begin();
-
-        // iterate using find_if so we dont enter the loop
-        // if the square is empty
-        // loops until iterator reached board.end
-        while((it = std::find_if(it, board.end(), isSquareEmpty)) != board.end()) {
-            // current position we check (row, col)
-            std::pair<int, int> position = it->first;
-            
-            // set to accumulate flippable pieces in all directions
-            std::set<std::pair<int, int>> totalFlippablePieces;
-
-            // check each direction for flippable pieces
-            for (const auto& direction : directions) {
-                // temporary set for the current direction
-                std::set<std::pair<int, int>> toFlip;
-                if (findFlippablePieces(position, player, direction, toFlip)) {
-                    // add flippable pieces in this direction to the total list
-                    totalFlippablePieces.insert(toFlip.begin(), toFlip.end());
-                }
-            }
-
-            // if there are any flippable pieces, store the move in the map
-            if (!totalFlippablePieces.empty()) {
-                validMovesMap[position] = totalFlippablePieces;
-            }
-            
-            // increment the iterator
-            it++;
-        }
-        return validMovesMap;  // return the map of valid moves with their flippable pieces
-    }
-    
-    // checks if there are valid moves left for the current player
-    //
-    // parameters:
-    // std::stack<PlayerMove>& gameHistory - a stack representing the history of moves in the game
-    // int currentPlayer - the current player's number (1 for 'X', 2 for 'O')
-    //
-    // returns:
-    // bool - true if there are valid moves left, false otherwise
-    bool areValidMovesLeftForPlayer(
-        std::stack<PlayerMove> &gameHistory, 
-        int currentPlayer
-    ) {
-        // by default the move is valid
-        bool validMoves = true;
-
-        // if the board is full
-        if (gameHistory.size() >= maxBoardSize * maxBoardSize) {
-            validMoves = false;
-        }
-
-        // return the boolean
-        return validMoves;
-    }
-
-    // prints the board in ASCII format, showing 'X', 'O', and '.' for empty spaces
-    //
-    // parameters:
-    // none
-    //
-    // returns:
-    // void - does not return a value
-    void printBoard() const {
-        for (int row = 0; row < maxBoardSize; ++row) {
-            for (int col = 0; col < maxBoardSize; ++col) {
-                int value = getBoardPlaceValue({row, col});
-                if (value == 0)
-                    std::cout << ". ";
-                else if (value == 1)
-                    std::cout << "X ";
-                else if (value == 2)
-                    std::cout << "O ";
-            }
-            std::cout << std::endl;
-        }
-    }
-    
-    // counts the tokens for each player and displays the winner or if the game is a draw
-    //
-    // parameters:
-    // none
-    //
-    // returns:
-    // void - does not return a value
-    void showWinner() const {
-        // iterate over the board player TWICE to count X and O
-        // NOTE: its more efficent to use for here iterate once
-        // but count is used due to project requirements
-        int countX = std::count_if(board.begin(), board.end(), [](const auto& pair) {
-            return pair.second.getValue() == 1;
-        });
-        int countO = std::count_if(board.begin(), board.end(), [](const auto& pair) {
-            return pair.second.getValue() == 2;
-        });
-        
-        /*
-        // store for the player counts
-        int countX = 0;
-        int countO = 0;
-
-        // iterate over the board to count tokens
-        for (auto it = board.begin(); it != board.end(); ++it) {
-            // the value of the player at that location
-            int value = it->second.getValue();
-            // if value is player X
-            if (value == 1) { 
-                countX++;  // Player X
-            } else if (value == 2) {
-                countO++;  // Player O
-            }
-        }
-        */
-        
-        this->printBoard();
-
-        // display player X tokens
-        std::cout << "X: ";
-        for (int i = 0; i < countX; ++i) {
-            std::cout << ". ";
-        }
-        std::cout << std::endl;
-
-        // display player O tokens
-        std::cout << "O: ";
-        for (int i = 0; i < countO; ++i) {
-            std::cout << ". ";
-        }
-        std::cout << std::endl;
-
-        // display the winner or draw
-        if (countX > countO) {
-            std::cout << "Player X wins (" << countX << "-" << countO << ")\n";
-        } else if (countO > countX) {
-            std::cout << "Player O wins (" << countO << "-" << countX << ")\n";
-        } else {
-            std::cout << "It's a draw (" << countX << "-" << countO << ")\n";
-        }
-    }
-
-    // retrieves the maximum size of the board
-    //
-    // parameters:
-    // none
-    //
-    // returns:
-    // int - the maximum size of the board
-    int getMaxBoardSize() const {
-        return maxBoardSize;
-    }
-};
-
-
-// prints all possible moves and their corresponding flip counts
-// displays each valid move location and the number of pieces that would be flipped
+#include <vector>
+#include <iomanip>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+
+// include board implementation
+#include "Board.h"
+// include transposition table implementation
+#include "TranspositionTable.h"
+// include the AI search
+#include "Search.h"
+// include headless self-play
+#include "SelfPlay.h"
+// include n-tuple training implementation
+#include "NTupleTrainer.h"
+// include opening book builder
+#include "OpeningBook.h"
+// include game server implementation
+#include "GameServer.h"
+// include game record implementation
+#include "GameRecord.h"
+// include game record analysis
+#include "GameAnalysis.h"
+// include terminal renderer implementation
+#include "TerminalRenderer.h"
+
+
+// adds a line for each possible move and its flip count to a frame
+// shows each valid move location and the number of pieces that would be flipped
 //
 // parameters:
-// std::map<std::pair<int, int>, std::set<std::pair<int, int>>> validMoves
-//                                - a map of valid moves where each key is a board position 
-//                                  and the associated value is a set of positions that would 
-//                                  be flipped by that move
+// const MoveList& validMoves       - the valid moves, each with the number of 
+//                                  pieces that would be flipped by that move
+// std::vector<std::string>& lines  - the frame the lines are added to
 //
 // returns:
 // void - does not return a value
 
-void printPossibleMoves(std::map<std::pair<int, int>, std::set<std::pair<int, int>>> validMoves) {
+void addPossibleMoves(const MoveList& validMoves, std::vector<std::string>& lines) {
     for (const auto& move : validMoves) {
-        std::pair<int, int> key = move.first;
-        int setSize = move.second.size();
-        std::cout << "Move (" << key.first+1 << ", " << key.second+1 << ") has " << setSize << " possible flip(s).\n";
+        std::pair<int, int> key = move.position();
+        int setSize = move.flipCount;
+        lines.push_back("Move (" + std::to_string(key.first+1) + ", " + std::to_string(key.second+1) + ") has " +
+                        std::to_string(setSize) + " possible flip(s).");
     }
 }
 
@@ -485,54 +99,55 @@ bool isPlayerMoveValid(Board &theBoard, int player, std::pair<int, int> location
 
 // gets the player's move, ensuring it is within bounds and valid
 // repeatedly prompts for input until a valid move is entered
-// clears the screen, displays the board, and provides move assistance if enabled
+// draws the status, the board, and move assistance if enabled, only what
+// changed since the last prompt is redrawn
 //
 // parameters:
 // int player                       - the player number (1 for 'X', 2 for 'O')
 // Board& theBoard                  - reference to the game board object
-// const std::map<std::pair<int, int>, std::set<std::pair<int, int>>>& validMoves
-//                                   - map of valid moves, with each key as a board 
-//                                     position and the associated value as positions to flip
+// const MoveList& validMoves      - list of valid moves, each with the 
+//                                     pieces it flips
 // std::string statusMessage          - message to display from the previous turn
 // bool moveAssistOn                - indicates if move assistance is enabled
+// TerminalRenderer& renderer       - draws the screen, remembers what it shows
 //
 // returns:
 // std::pair<int, int>              - coordinates of the player's chosen move (row, column)
 
 std::pair<int, int> getPlayerMove(
     int player, Board &theBoard, 
-    const std::map<std::pair<int, int>, 
-    std::set<std::pair<int, int>>>& validMoves,
+    const MoveList& validMoves,
     std::string statusMessage,
-    bool moveAssistOn
+    bool moveAssistOn,
+    TerminalRenderer& renderer
 ) {
-    // error message to print when we clear the screen
+    // error message to print below the board
     std::string errorMessage;
     std::pair<int, int> playerMoveLocation;
     int maxSize = theBoard.getMaxBoardSize();
+    std::vector<std::string> lines;
 
     while (true) {
-        // clear the screen and set cursor to the upper left
-        // ANSI escape codes
-        // clear the screen \033[2J
-        // reset cursor \033[H
-        std::cout << "\033[2J\033[H"; 
-        std::cout << statusMessage << "\n";
+        lines.clear();
+        lines.push_back(statusMessage);
         // print X or O for the player
-        std::cout << "Player " << (player == 1 ? "X" : "O") << "'s turn.\n";
-        theBoard.printBoard();
+        lines.push_back("Player " + std::string(player == 1 ? "X" : "O") + "'s turn.");
+        for (int row = 0; row < maxSize; ++row) {
+            lines.push_back(theBoard.rowText(row));
+        }
         
         if (moveAssistOn) {
-            printPossibleMoves(validMoves);
+            addPossibleMoves(validMoves, lines);
         }
 
         // print the error message if there is one
         if (!errorMessage.empty()) {
-            std::cout << errorMessage << "\n";
+            lines.push_back(errorMessage);
         }
 
         // prompt for input
-        std::cout << "Enter your move (row and column, e.g., '3 4'): ";
+        lines.push_back("Enter your move (row and column, e.g., '3 4'): ");
+        renderer.render(lines);
 
         // check if the input is valid
         if (!(std::cin >> playerMoveLocation.first >> playerMoveLocation.second)) {
@@ -555,8 +170,8 @@ std::pair<int, int> getPlayerMove(
             continue;
         }
 
-        // check if the move is in the validMoves map
-        if (validMoves.find(playerMoveLocation) == validMoves.end()) {
+        // check if the move is in the validMoves list
+        if (validMoves.find(playerMoveLocation) == nullptr) {
             errorMessage = "Invalid move. Please choose a position with available flips.";
             continue;
         }
@@ -568,222 +183,6 @@ std::pair<int, int> getPlayerMove(
 }
 
 
-// populates the AVL tree with moves and their scores using a minimax approach,
-// considering the difference between ai_flips and player_flips across depths.
-//
-// caching is used to optimize recursive evaluation by reusing cached scores
-// for board states. 
-// if a board state has been evaluated at an equal or greater
-// depth, the cached score is used. for the root level (depth == 0), 
-// the move tree
-// is always rebuilt to ensure consistency, even if a cached score is available.
-//
-// parameters:
-// AVLTree<std::pair<int, std::pair<int, int>>>& moveTree - the AVL tree to populate with moves
-// const std::map<std::pair<int, int>, std::set<std::pair<int, int>>>& validMoves - valid moves and their flips
-// Board& board - the current game board state
-// int currentPlayer - the current player (1 for X, 2 for O)
-// int depth - the current recursion depth
-// int maxDepth - the maximum recursion depth
-//
-// returns:
-// int - the best move's score at this level
-
-int populateMoveTree(
-    AVLTree<std::pair<int, std::pair<int, int>>>& moveTree,
-    const std::map<std::pair<int, int>, std::set<std::pair<int, int>>>& validMoves,
-    Board& board,
-    int currentPlayer,
-    int depth,
-    int maxDepth
-) {
-    // static cache for board scores
-    static std::unordered_map<std::string, std::pair<int, int>> scoreCache;
-
-    int opponent = (currentPlayer == 1) ? 2 : 1;
-
-    // check if we've reached the maximum depth or there are no valid moves
-    if (depth == maxDepth || validMoves.empty()) {
-        // use a simple heuristic or return a neutral score
-        return 0;
-    }
-
-    // calculate the board hash
-    std::string boardHash = board.hashBoard();
-
-    // check the cache for the board state
-    auto cacheIt = scoreCache.find(boardHash);
-    if (cacheIt != scoreCache.end() && cacheIt->second.second >= depth) {
-        // use cached score if depth is sufficient
-        int cachedScore = cacheIt->second.first;
-
-        // populate the move tree with valid moves for consistency
-        if (depth == 0) {
-            for (const auto& move : validMoves) {
-                moveTree.insert({cachedScore, move.first});
-            }
-        }
-
-        return cachedScore;
-    }
-
-    // initialize the best score
-    int bestScore = (depth % 2 == 0) ? -std::numeric_limits<int>::max() : std::numeric_limits<int>::max();
-
-    // iterate through all valid moves
-    for (const auto& move : validMoves) {
-        // simulate the board after the move
-        Board simulatedBoard = board;
-        simulatedBoard.placePiece(move.first, currentPlayer, move.second);
-
-        // calculate immediate flips
-        int aiFlips = move.second.size();
-
-        // get valid moves for the next player
-        auto nextValidMoves = simulatedBoard.getValidMoves(opponent);
-
-        // recursively calculate the score for the opponent's response
-        int childScore = populateMoveTree(
-            moveTree,
-            nextValidMoves,
-            simulatedBoard,
-            opponent,
-            depth + 1,
-            maxDepth
-        );
-
-        // current score for this move
-        int currentScore = (depth % 2 == 0)
-                               ? aiFlips - childScore  // maximize ai's score
-                               : childScore - aiFlips; // minimize opponent's score
-
-        // update the best score
-        if (depth % 2 == 0) {
-            bestScore = std::max(bestScore, currentScore);
-        } else {
-            bestScore = std::min(bestScore, currentScore);
-        }
-
-        // add the move to the tree if at the root
-        if (depth == 0) {
-            moveTree.insert({currentScore, move.first});
-        }
-    }
-
-    // update the cache with the best score and depth
-    scoreCache[boardHash] = {bestScore, depth};
-
-    return bestScore;
-}
-
-// finds the move with the highest score in the AVL tree by traversing to the rightmost node
-//
-// parameters:
-// AVLNode<std::pair<int, std::pair<int, int>>>* root - the root node of the AVL tree
-//
-// returns:
-// std::pair<int, int> - the move (row, column) with the highest score
-
-std::pair<int, int> findBestMove(AVLNode<std::pair<int, std::pair<int, int>>>* root) {
-    // sanity check
-    if (!root) {
-        throw std::runtime_error("The move tree is empty.");
-    }
-
-    // traverse to right most for highest score
-    AVLNode<std::pair<int, std::pair<int, int>>>* current = root;
-    while (current->right != nullptr) {
-        current = current->right;
-    }
-    
-    // return the move
-    return current->data.second; 
-}
-
-// performs an inorder traversal of the AVL tree and collects all nodes in a vector
-//
-// parameters:
-// AVLNode<std::pair<int, std::pair<int, int>>>* root - the root node of the AVL tree
-// std::vector<std::pair<int, std::pair<int, int>>>& moves - a vector to store the collected moves
-//
-// returns:
-// none
-
-void collectInorderMoves(
-    AVLNode<std::pair<int, std::pair<int, int>>>* root,
-    std::vector<std::pair<int, std::pair<int, int>>>& moves
-) {
-    // if we don't have a root 
-    // we return and the vector is empty
-    // should never happen
-    if (!root) return;
-    
-    collectInorderMoves(root->left, moves);     // left
-    moves.push_back(root->data);               // current
-    collectInorderMoves(root->right, moves);   // right
-}
-
-// selects a random move from the AVL tree by collecting all moves in sorted order
-//
-// parameters:
-// AVLNode<std::pair<int, std::pair<int, int>>>* root - the root node of the AVL tree
-//
-// returns:
-// std::pair<int, int> - a random move (row, column) from the AVL tree
-
-std::pair<int, int> getRandomMove(AVLNode<std::pair<int, std::pair<int, int>>>* root) {
-    // move tree is empty for some reason
-    // should never happen
-    if (!root) {
-        throw std::runtime_error("The move tree is empty.");
-    }
-    
-    // all the moves
-    std::vector<std::pair<int, std::pair<int, int>>> allMoves;
-    // collect the moves into an array
-    collectInorderMoves(root, allMoves); 
-
-    // pick a move, any move
-    std::srand(std::time(0));
-    int randomIndex = std::rand() % allMoves.size();
-    return allMoves[randomIndex].second; // Return the random move (row, column)
-}
-
-// determines the AI's move by populating an AVL tree with valid moves and selecting the best or random move
-//
-// parameters:
-// const std::map<std::pair<int, int>, std::set<std::pair<int, int>>>& validMoves - a map of valid moves and their corresponding flips
-// Board& board - the current game board
-//
-// returns:
-// std::pair<int, int> - the selected move (row, column)
-
-std::pair<int, int> getAIMove(
-    const std::map<std::pair<int, int>, std::set<std::pair<int, int>>>& validMoves,
-    Board& board,
-    int currentPlayer
-) {
-    // maxDepth
-    int maxDepth = 3; // just 3 for now
-    
-    // create AVL tree we will use
-    AVLTree<std::pair<int, std::pair<int, int>>> moveTree;
-
-    // populate the AVL tree with moves
-    populateMoveTree(moveTree, validMoves, board, currentPlayer, 0, maxDepth);
-
-    // choose random move or  "best" move
-    // makes the games more "interesting"
-    if (std::rand() % 2 == 0) {
-        // pick a random move
-        return getRandomMove(moveTree.get_root());
-    } else {
-        // pick the "best" move
-        return findBestMove(moveTree.get_root());
-    }
-}
-
-
 // prompts the user to enter the board size with a minimum value of 4
 // repeatedly asks for input until the user enters a valid size (4 or greater)
 //
@@ -878,6 +277,569 @@ bool getPlayAgain() {
 }
 
 
+// options that can be set from the command line
+struct GameOptions {
+    // memory budget for the AI's transposition table
+    size_t ttMegabytes = 64;
+    TTReplacement ttReplacement = TTReplacement::DEPTH_PREFERRED;
+    // print the table counters after each game
+    bool ttStats = false;
+    // AI search mode and depth
+    SearchOptions search;
+    // self-play matches search against this engine if set
+    bool hasChallenger = false;
+    SearchMode challengerMode = SearchMode::ALPHA_BETA;
+    // AI vs AI games to play without a terminal, 0 for the interactive game
+    int selfPlayGames = 0;
+    // board size for self-play
+    int boardSize = 8;
+    // n-tuple weights file to map for --eval ntuple
+    std::string ntupleWeightsPath;
+    // weights file to train, trains instead of playing if set
+    std::string trainNTuplePath;
+    // position store consulted before every AI search
+    std::string bookPath;
+    // plies of opening book to build into the store, builds instead of playing if above 0
+    int buildBookPlies = 0;
+    // port to serve games on, serves instead of playing if set
+    int servePort = -1;
+    // game record file every finished game is appended to
+    std::string recordPath;
+    // game record file to replay, replays instead of playing if set
+    std::string replayPath;
+    // game record file to analyze, analyzes instead of playing if set
+    std::string analyzePath;
+    // seed of the AI's random moves, 0 picks one at random
+    uint64_t seed = 0;
+    // the open record file, set in main when recordPath is
+    GameRecordWriter* recorder = nullptr;
+    bool showHelp = false;
+};
+
+
+// parses the command line options
+//
+// parameters:
+// int argc - the number of arguments
+// char* argv[] - the arguments
+//
+// returns:
+// GameOptions - the parsed options, defaults for anything not given
+//
+// throws:
+// std::invalid_argument if an option is unknown or its value is invalid
+
+GameOptions parseOptions(int argc, char* argv[]) {
+    GameOptions options;
+    bool depthGiven = false;
+    bool evalGiven = false;
+
+    // reads the value that follows an option
+    auto nextValue = [&](int& i) -> std::string {
+        if (i + 1 >= argc) {
+            throw std::invalid_argument(std::string("Missing value for ") + argv[i]);
+        }
+        return argv[++i];
+    };
+
+    // reads an integer value, at least minimum
+    auto nextNumber = [&](int& i, long minimum = 1) -> long {
+        std::string option = argv[i];
+        std::string value = nextValue(i);
+        try {
+            size_t used = 0;
+            long number = std::stol(value, &used);
+            if (used == value.size() && number >= minimum) {
+                return number;
+            }
+        } catch (const std::exception&) {
+            // fall through to the error below
+        }
+        throw std::invalid_argument("Invalid value for " + option + ": " + value);
+    };
+
+    // reads a search mode
+    auto nextMode = [&](int& i) -> SearchMode {
+        std::string option = argv[i];
+        std::string value = nextValue(i);
+        if (value == "minimax") {
+            return SearchMode::MINIMAX;
+        } else if (value == "alphabeta") {
+            return SearchMode::ALPHA_BETA;
+        } else if (value == "mcts") {
+            return SearchMode::MCTS;
+        }
+        throw std::invalid_argument("Invalid value for " + option + ": " + value);
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tt-mb") {
+            options.ttMegabytes = nextNumber(i);
+        } else if (arg == "--tt-replace") {
+            std::string value = nextValue(i);
+            if (value == "depth") {
+                options.ttReplacement = TTReplacement::DEPTH_PREFERRED;
+            } else if (value == "always") {
+                options.ttReplacement = TTReplacement::ALWAYS_REPLACE;
+            } else {
+                throw std::invalid_argument("Invalid value for --tt-replace: " + value);
+            }
+        } else if (arg == "--search") {
+            options.search.mode = nextMode(i);
+        } else if (arg == "--vs-search") {
+            options.challengerMode = nextMode(i);
+            options.hasChallenger = true;
+        } else if (arg == "--playouts") {
+            options.search.mctsPlayouts = nextNumber(i);
+        } else if (arg == "--random") {
+            long percent = nextNumber(i, 0);
+            if (percent > 100) {
+                throw std::invalid_argument("Invalid value for --random: " + std::to_string(percent));
+            }
+            options.search.randomMovePercent = static_cast<int>(percent);
+        } else if (arg == "--eval") {
+            std::string value = nextValue(i);
+            if (value == "positional") {
+                options.search.evaluator = EvaluatorKind::POSITIONAL;
+            } else if (value == "flips") {
+                options.search.evaluator = EvaluatorKind::FLIPS;
+            } else if (value == "ntuple") {
+                options.search.evaluator = EvaluatorKind::NTUPLE;
+            } else {
+                throw std::invalid_argument("Invalid value for --eval: " + value);
+            }
+            evalGiven = true;
+        } else if (arg == "--ntuple-weights") {
+            options.ntupleWeightsPath = nextValue(i);
+        } else if (arg == "--train-ntuple") {
+            options.trainNTuplePath = nextValue(i);
+        } else if (arg == "--book") {
+            options.bookPath = nextValue(i);
+        } else if (arg == "--build-book") {
+            options.buildBookPlies = nextNumber(i);
+            if (options.buildBookPlies < 1) {
+                throw std::invalid_argument("--build-book needs at least 1 ply.");
+            }
+        } else if (arg == "--depth") {
+            options.search.maxDepth = nextNumber(i);
+            depthGiven = true;
+        } else if (arg == "--endgame") {
+            options.search.endgameEmpties = nextNumber(i, 0);
+        } else if (arg == "--endgame-nodes") {
+            options.search.endgameNodes = nextNumber(i, 0);
+        } else if (arg == "--ai-ms") {
+            options.search.timeLimitMs = nextNumber(i);
+        } else if (arg == "--threads") {
+            options.search.threads = nextNumber(i);
+        } else if (arg == "--selfplay") {
+            options.selfPlayGames = nextNumber(i);
+        } else if (arg == "--size") {
+            options.boardSize = nextNumber(i);
+            if (options.boardSize < 4) {
+                throw std::invalid_argument("Board size must be at least 4.");
+            }
+        } else if (arg == "--record") {
+            options.recordPath = nextValue(i);
+        } else if (arg == "--replay") {
+            options.replayPath = nextValue(i);
+        } else if (arg == "--analyze") {
+            options.analyzePath = nextValue(i);
+        } else if (arg == "--serve") {
+            options.servePort = nextNumber(i, 0);
+            if (options.servePort > 65535) {
+                throw std::invalid_argument("Invalid port for --serve: " + std::to_string(options.servePort));
+            }
+        } else if (arg == "--seed") {
+            std::string value = nextValue(i);
+            try {
+                size_t used = 0;
+                options.seed = std::stoull(value, &used);
+                if (used != value.size() || value[0] == '-' || options.seed == 0) {
+                    throw std::invalid_argument(value);
+                }
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Invalid value for --seed: " + value);
+            }
+        } else if (arg == "--no-fixed-boards") {
+            options.search.fixedBoards = false;
+        } else if (arg == "--tt-stats") {
+            options.ttStats = true;
+        } else if (arg == "--help" || arg == "-h") {
+            options.showHelp = true;
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+
+    // a weights file on its own is used for the evaluation
+    if (!options.ntupleWeightsPath.empty() && !evalGiven) {
+        options.search.evaluator = EvaluatorKind::NTUPLE;
+    }
+    if (options.search.evaluator == EvaluatorKind::NTUPLE && options.ntupleWeightsPath.empty()) {
+        throw std::invalid_argument("--eval ntuple needs --ntuple-weights FILE");
+    }
+    if (options.buildBookPlies > 0 && options.bookPath.empty()) {
+        throw std::invalid_argument("--build-book needs --book FILE");
+    }
+    if (options.hasChallenger && options.selfPlayGames == 0) {
+        throw std::invalid_argument("--vs-search needs --selfplay N");
+    }
+
+    // a time limit on its own searches as deep as the time allows
+    if (options.search.timeLimitMs > 0 && !depthGiven) {
+        options.search.maxDepth = ITERATIVE_MAX_DEPTH;
+    }
+    return options;
+}
+
+
+// prints the command line options
+//
+// parameters:
+// none
+//
+// returns:
+// void - does not return a value
+
+void printUsage() {
+    std::cout << "Usage: othello [options]\n";
+    std::cout << "  --search MODE          AI search: alphabeta, minimax or mcts (default alphabeta)\n";
+    std::cout << "  --playouts N           mcts playouts per move without --ai-ms (default " << MCTS_DEFAULT_PLAYOUTS << ")\n";
+    std::cout << "  --random N             percent of AI moves played at random (default 50)\n";
+    std::cout << "  --eval NAME            AI evaluation: positional, flips or ntuple (default positional)\n";
+    std::cout << "  --ntuple-weights FILE  pattern weights for --eval ntuple, memory mapped\n";
+    std::cout << "  --train-ntuple FILE    play --selfplay N games (default 1000) at --size and --depth,\n";
+    std::cout << "                         fit the pattern weights to them and write FILE\n";
+    std::cout << "  --book FILE            opening book and solved endgames played before searching\n";
+    std::cout << "  --build-book N         search every position of the first N plies at --size and --depth\n";
+    std::cout << "                         and append the best moves to --book FILE\n";
+    std::cout << "  --depth N              AI search depth in plies (default 3)\n";
+    std::cout << "  --endgame N            solve the game exactly with N or fewer empty squares, 0 never\n";
+    std::cout << "                         (default " << ENDGAME_DEFAULT_EMPTIES << ")\n";
+    std::cout << "  --endgame-nodes N      without --ai-ms give up a solve after N nodes and search instead,\n";
+    std::cout << "                         0 never gives up (default " << ENDGAME_DEFAULT_NODES << ")\n";
+    std::cout << "  --ai-ms N              AI time per move in ms, iterative deepening up to --depth\n";
+    std::cout << "  --threads N            search threads, Lazy SMP for alpha-beta, parallel playouts for mcts\n";
+    std::cout << "                         (default 1)\n";
+    std::cout << "  --tt-mb N              transposition table memory budget in MB (default 64)\n";
+    std::cout << "  --tt-replace POLICY    table replacement policy: depth or always (default depth)\n";
+    std::cout << "  --tt-stats             print table hit/miss/collision counters after each game\n";
+    std::cout << "  --no-fixed-boards      search the Board itself instead of a FixedBoard copy on 6x6,\n";
+    std::cout << "                         8x8, 10x10 and 12x12 boards\n";
+    std::cout << "  --seed N               seed of the AI's random moves, at least 1, runs with the same seed\n";
+    std::cout << "                         play the same (default a new seed every run)\n";
+    std::cout << "  --selfplay N           play N AI vs AI games with no terminal I/O and report throughput\n";
+    std::cout << "  --size N               self-play board size (default 8)\n";
+    std::cout << "                         in self-play --threads sets how many games run at once\n";
+    std::cout << "  --vs-search MODE       in self-play match --search against MODE, alternating colours\n";
+    std::cout << "  --record FILE          append every finished game, played or self-play, to FILE\n";
+    std::cout << "  --replay FILE          replay the games recorded in FILE and report the throughput\n";
+    std::cout << "  --analyze FILE         replay FILE on --threads threads and report outcomes by board size,\n";
+    std::cout << "                         branching factor and outcomes by first move\n";
+    std::cout << "  --serve PORT           host games over TCP on PORT (0 picks one), --threads AI workers\n";
+    std::cout << "  --help                 show this message\n";
+}
+
+
+// prints the transposition table counters
+//
+// parameters:
+// const TranspositionTable& table - the table to report on
+//
+// returns:
+// void - does not return a value
+
+void printTableStats(const TranspositionTable& table) {
+    TTStats stats = table.getStats();
+    double hitRate = stats.probes ? 100.0 * stats.hits / stats.probes : 0.0;
+
+    std::cout << "Transposition table: " << table.size() << " entries ("
+              << table.memoryUsed() / (1024 * 1024) << " MB)\n";
+    std::cout << "  probes " << stats.probes << ", hits " << stats.hits
+              << " (" << std::fixed << std::setprecision(1) << hitRate << "%), misses " << stats.misses
+              << ", collisions " << stats.collisions << "\n";
+    std::cout << "  stores " << stats.stores << ", overwrites " << stats.overwrites
+              << ", rejected " << stats.rejected << "\n";
+}
+
+
+// retrieves the command line name of a search mode
+//
+// parameters:
+// SearchMode mode - the mode
+//
+// returns:
+// const char* - the name --search takes
+
+const char* searchModeName(SearchMode mode) {
+    switch (mode) {
+        case SearchMode::MINIMAX:
+            return "minimax";
+        case SearchMode::MCTS:
+            return "mcts";
+        default:
+            return "alphabeta";
+    }
+}
+
+
+// runs the headless self-play games and prints the throughput and results
+// each game runs on its own thread with a single threaded search,
+// --threads sets how many games run at once
+//
+// parameters:
+// const GameOptions& options - the command line options
+//
+// returns:
+// void - does not return a value
+
+void runSelfPlayReport(const GameOptions& options) {
+    SelfPlayOptions selfPlay;
+    selfPlay.games = options.selfPlayGames;
+    selfPlay.boardSize = options.boardSize;
+    selfPlay.workers = options.search.threads;
+    selfPlay.ttMegabytes = options.ttMegabytes;
+    selfPlay.ttReplacement = options.ttReplacement;
+    selfPlay.search = options.search;
+    // the cores are already busy with games
+    selfPlay.search.threads = 1;
+    selfPlay.recorder = options.recorder;
+    // a seeded run plays the same games whichever worker takes them
+    selfPlay.reproducible = options.seed != 0;
+    if (options.hasChallenger) {
+        selfPlay.hasChallenger = true;
+        selfPlay.challenger = selfPlay.search;
+        selfPlay.challenger.mode = options.challengerMode;
+    }
+
+    SelfPlayResult result = runSelfPlay(selfPlay);
+    double seconds = std::max(result.seconds, 1e-9);
+
+    std::cout << "Self-play: " << result.games << " games on " << selfPlay.boardSize << "x"
+              << selfPlay.boardSize << ", workers " << std::min(selfPlay.workers, selfPlay.games)
+              << ", depth " << selfPlay.search.maxDepth << ", seed " << randomSeed() << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  time " << result.seconds << " s, " << result.games / seconds << " games/s, "
+              << result.moves / seconds << " moves/s\n";
+    std::cout << std::setprecision(0);
+    std::cout << "  nodes " << result.nodes << ", " << result.nodes / seconds << " nodes/s\n";
+    std::cout << std::setprecision(1);
+    std::cout << "  X wins " << result.xWins << " (" << 100.0 * result.xWins / result.games << "%), O wins "
+              << result.oWins << " (" << 100.0 * result.oWins / result.games << "%), draws "
+              << result.draws << " (" << 100.0 * result.draws / result.games << "%)\n";
+    if (selfPlay.hasChallenger) {
+        const SearchMode modes[2] = {selfPlay.search.mode, selfPlay.challenger.mode};
+        for (int engine = 0; engine < 2; ++engine) {
+            double moveMs = 1000.0 * result.engineSeconds[engine] / std::max<uint64_t>(result.engineMoves[engine], 1);
+            std::cout << std::setprecision(1);
+            std::cout << "  " << searchModeName(modes[engine]) << (engine == 0 ? " (--search)" : " (--vs-search)")
+                      << " wins " << result.engineWins[engine] << " ("
+                      << 100.0 * result.engineWins[engine] / result.games << "%), " << std::setprecision(2)
+                      << moveMs << " ms per move\n";
+        }
+    }
+}
+
+
+// replays every game of a record file and prints the throughput and results
+// the file is mapped and read one record at a time
+//
+// parameters:
+// const GameOptions& options - the command line options
+//
+// returns:
+// void - does not return a value
+
+void runReplay(const GameOptions& options) {
+    GameRecordReader reader(options.replayPath);
+    GameRecordView record;
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t xWins = 0;
+    uint64_t oWins = 0;
+    uint64_t draws = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (reader.next(record)) {
+        Board board = replayGameRecord(record, [&](const Board&, int, const Move&) { ++moves; });
+        int xCount = board.countPieces(1);
+        int oCount = board.countPieces(2);
+        if (xCount > oCount) {
+            ++xWins;
+        } else if (oCount > xCount) {
+            ++oWins;
+        } else {
+            ++draws;
+        }
+        ++games;
+    }
+    double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+
+    std::cout << "Replay: " << games << " games, " << moves << " moves from " << options.replayPath << " ("
+              << reader.offset() << " bytes)\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  time " << seconds << " s, " << std::setprecision(0) << games / seconds << " games/s, "
+              << moves / seconds << " moves/s\n";
+    if (games > 0) {
+        std::cout << std::setprecision(1);
+        std::cout << "  X wins " << xWins << " (" << 100.0 * xWins / games << "%), O wins " << oWins << " ("
+                  << 100.0 * oWins / games << "%), draws " << draws << " (" << 100.0 * draws / games << "%)\n";
+    }
+}
+
+
+// prints how a set of games ended as counts and percentages
+//
+// parameters:
+// const GameOutcomes& outcomes - the games
+//
+// returns:
+// void - does not return a value
+
+void printOutcomes(const GameOutcomes& outcomes) {
+    double games = static_cast<double>(std::max<uint64_t>(outcomes.games, 1));
+    std::cout << "X wins " << outcomes.xWins << " (" << 100.0 * outcomes.xWins / games << "%), O wins "
+              << outcomes.oWins << " (" << 100.0 * outcomes.oWins / games << "%), draws " << outcomes.draws
+              << " (" << 100.0 * outcomes.draws / games << "%)";
+}
+
+
+// replays every game of a record file across --threads threads and prints
+// the outcomes, branching factor and first move table of each board size
+//
+// parameters:
+// const GameOptions& options - the command line options
+//
+// returns:
+// void - does not return a value
+
+void runAnalysis(const GameOptions& options) {
+    GameAnalysis analysis = analyzeGameRecords(options.analyzePath, options.search.threads);
+    double seconds = std::max(analysis.seconds, 1e-9);
+
+    std::cout << "Analysis: " << analysis.games << " games, " << analysis.moves << " moves from "
+              << options.analyzePath << " (" << analysis.bytes << " bytes), " << analysis.threads << " threads\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  time " << seconds << " s, " << std::setprecision(0) << analysis.games / seconds << " games/s, "
+              << analysis.moves / seconds << " moves/s\n";
+
+    for (size_t size = 0; size < analysis.bySize.size(); ++size) {
+        const BoardSizeAnalysis& sizeAnalysis = analysis.bySize[size];
+        uint64_t games = sizeAnalysis.outcomes.games;
+        if (games == 0) {
+            continue;
+        }
+        std::cout << std::setprecision(1);
+        std::cout << "\n" << size << "x" << size << ": " << games << " games, ";
+        printOutcomes(sizeAnalysis.outcomes);
+        std::cout << "\n";
+        std::cout << std::setprecision(2);
+        std::cout << "  moves per game " << static_cast<double>(sizeAnalysis.moves) / games << ", passes per game "
+                  << static_cast<double>(sizeAnalysis.passes) / games << ", branching factor "
+                  << sizeAnalysis.branchingFactor() << "\n";
+        std::cout << "  first move (row col, 0 based):\n";
+        std::cout << std::setprecision(1);
+        for (size_t square = 0; square < sizeAnalysis.firstMoves.size(); ++square) {
+            const GameOutcomes& outcomes = sizeAnalysis.firstMoves[square];
+            if (outcomes.games == 0) {
+                continue;
+            }
+            std::cout << "  " << std::setw(3) << square / size << " " << std::setw(3) << square % size << "  "
+                      << std::setw(9) << outcomes.games << " games, ";
+            printOutcomes(outcomes);
+            std::cout << "\n";
+        }
+    }
+}
+
+
+// set by SIGINT or SIGTERM to stop the game server
+std::atomic<bool> serverStopRequested(false);
+
+extern "C" void requestServerStop(int) {
+    serverStopRequested = true;
+}
+
+
+// serves games over TCP until interrupted
+// each AI worker runs a single threaded search, --threads sets how many there are
+//
+// parameters:
+// const GameOptions& options - the command line options
+//
+// returns:
+// void - does not return a value
+
+void runGameServer(const GameOptions& options) {
+    ServerOptions server;
+    server.port = options.servePort;
+    server.workers = options.search.threads;
+    server.ttMegabytes = options.ttMegabytes;
+    server.ttReplacement = options.ttReplacement;
+    server.search = options.search;
+    // the cores are already busy with other games
+    server.search.threads = 1;
+    server.stop = &serverStopRequested;
+
+    std::signal(SIGINT, requestServerStop);
+    std::signal(SIGTERM, requestServerStop);
+    GameServer gameServer(server);
+    gameServer.run(std::cout);
+}
+
+
+// trains n-tuple weights from self-play games and prints what was done
+//
+// parameters:
+// const GameOptions& options - the command line options
+//
+// returns:
+// void - does not return a value
+
+void runNTupleTraining(const GameOptions& options) {
+    NTupleTrainingOptions training;
+    training.games = (options.selfPlayGames > 0) ? options.selfPlayGames : 1000;
+    training.boardSize = options.boardSize;
+    training.ttMegabytes = options.ttMegabytes;
+    training.search = options.search;
+    training.search.threads = 1;
+    // the games are played with the evaluator being replaced
+    if (training.search.evaluator == EvaluatorKind::NTUPLE && !training.search.ntupleWeights) {
+        training.search.evaluator = EvaluatorKind::POSITIONAL;
+    }
+
+    NTupleTrainingResult result = trainNTupleWeights(training, options.trainNTuplePath);
+    std::cout << "N-tuple training: " << result.games << " games on " << training.boardSize << "x"
+              << training.boardSize << ", depth " << training.search.maxDepth << ", "
+              << result.positions << " positions\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  mean error " << result.meanError << " discs, time " << result.seconds << " s\n";
+    std::cout << "  wrote " << options.trainNTuplePath << "\n";
+}
+
+
+// builds the opening book into the position store and prints what was done
+//
+// parameters:
+// const GameOptions& options - the command line options, with the store set
+//
+// returns:
+// void - does not return a value
+
+void runBookBuild(const GameOptions& options) {
+    TranspositionTable table(options.ttMegabytes, options.ttReplacement);
+    OpeningBookResult result = buildOpeningBook(*options.search.positionStore, options.boardSize,
+                                                options.buildBookPlies, options.search, table);
+    std::cout << "Opening book: " << options.buildBookPlies << " plies on " << options.boardSize << "x"
+              << options.boardSize << ", depth " << options.search.maxDepth << ", "
+              << result.positions << " positions, " << result.added << " added\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  time " << result.seconds << " s, " << options.search.positionStore->size()
+              << " positions in " << options.bookPath << "\n";
+}
+
+
 // prints the rules of Othello
 // provides players with an overview of the game objectives, piece placement,
 // flipping mechanics, and victory conditions
@@ -914,12 +876,13 @@ void printRules() {
 // checking for valid moves, and determining the game outcome
 //
 // parameters:
-// none
+// const GameOptions& options - the command line options
+// TranspositionTable& table - the AI's cache, kept between games
 //
 // returns:
 // void - does not return a value
 
-void playGame() {
+void playGame(const GameOptions& options, TranspositionTable& table) {
     // players
     int currentPlayer = 1;
     int nextPlayer = 2;
@@ -937,10 +900,12 @@ void playGame() {
     
     Board theBoard(maxBoardSize);
     std::stack<PlayerMove> gameHistory;
+    // the screen, redrawn where it changed on each prompt
+    TerminalRenderer renderer;
     
     while (true) {
         // check if there are valid moves for this player
-        std::map<std::pair<int, int>, std::set<std::pair<int, int>>> validMoves = theBoard.getValidMoves(currentPlayer);
+        MoveList validMoves = theBoard.getValidMoves(currentPlayer);
         
         if (validMoves.size()==0) {
             // if the prev player didn't move
@@ -969,10 +934,10 @@ void playGame() {
         // and if we have an ai opponent
         if (currentPlayer == 2 && playerCount == 1) {
             // get the move from the "AI"
-            playerMove = getAIMove(validMoves, theBoard, currentPlayer);
+            playerMove = getAIMove(validMoves, theBoard, currentPlayer, table, options.search);
         } else {
             // get a valid move for human player
-            playerMove = getPlayerMove(currentPlayer, theBoard, validMoves, statusMessage, moveAssistOn);
+            playerMove = getPlayerMove(currentPlayer, theBoard, validMoves, statusMessage, moveAssistOn, renderer);
         }
         // the previous player moved
         prevPlayerMoved = true; 
@@ -983,7 +948,7 @@ void playGame() {
                 std::to_string(playerMove.second+1) + ")";
         
         // place the piece, pass pieces to be flipped
-        theBoard.placePiece(playerMove, currentPlayer, validMoves.at(playerMove));
+        theBoard.placePiece(*validMoves.find(playerMove), currentPlayer);
         
         // add this move to the gameHistory
         gameHistory.push(PlayerMove(currentPlayer, playerMove));
@@ -992,14 +957,150 @@ void playGame() {
         std::swap(currentPlayer, nextPlayer);
     }
     // display the statusMessage
-    std::cout << statusMessage << std::endl;
+    std::cout << statusMessage << "\n";
     
     // count the X and O and display the winner
     theBoard.showWinner();
+
+    // keep the game
+    if (options.recorder) {
+        try {
+            options.recorder->write(maxBoardSize, gameHistory);
+            options.recorder->flush();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+    }
+
+    // show how well the cache is doing
+    if (options.ttStats) {
+        printTableStats(table);
+    }
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    GameOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+    if (options.showHelp) {
+        printUsage();
+        return 0;
+    }
+    // every thread's random numbers come from this seed
+    if (options.seed != 0) {
+        setRandomSeed(options.seed);
+    }
+
+    // the evaluation weights are mapped once and shared by every search
+    std::unique_ptr<NTupleWeights> ntupleWeights;
+    if (!options.ntupleWeightsPath.empty()) {
+        try {
+            ntupleWeights.reset(new NTupleWeights(options.ntupleWeightsPath));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        options.search.ntupleWeights = ntupleWeights.get();
+    }
+
+    // the store is mapped once and shared by every search
+    std::unique_ptr<PositionStore> positionStore;
+    if (!options.bookPath.empty()) {
+        try {
+            positionStore.reset(new PositionStore(options.bookPath));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        options.search.positionStore = positionStore.get();
+    }
+
+    if (options.buildBookPlies > 0) {
+        try {
+            runBookBuild(options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!options.trainNTuplePath.empty()) {
+        try {
+            runNTupleTraining(options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!options.replayPath.empty()) {
+        try {
+            runReplay(options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!options.analyzePath.empty()) {
+        try {
+            runAnalysis(options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // finished games are appended to the record file
+    std::unique_ptr<GameRecordWriter> recorder;
+    if (!options.recordPath.empty()) {
+        try {
+            recorder.reset(new GameRecordWriter(options.recordPath));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        options.recorder = recorder.get();
+    }
+
+    if (options.servePort >= 0) {
+        try {
+            runGameServer(options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // headless mode, no prompts or screen clearing
+    if (options.selfPlayGames > 0) {
+        try {
+            runSelfPlayReport(options);
+            if (recorder) {
+                recorder->flush();
+                std::cout << "  recorded " << recorder->games() << " games to " << options.recordPath << "\n";
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // the AI's cache, bounded by --tt-mb and kept for every game played
+    TranspositionTable table(options.ttMegabytes, options.ttReplacement);
+
     printRules();
     do {
         // clear the screen and set cursor to the upper left
@@ -1008,7 +1109,7 @@ int main() {
         // reset cursor \033[H
         std::cout << "\033[2J\033[H"; 
         // start a new game
-        playGame();
+        playGame(options, table);
     } while (getPlayAgain());  // check if player wants to play again
     
     std::cout << "Thanks for playing." << std::endl;